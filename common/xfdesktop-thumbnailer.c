@@ -100,18 +100,52 @@ xfdesktop_thumbnailer_get_type(void)
     return xfdesktop_thumbnailer_type;
 }
 
+typedef struct
+{
+    gchar                    *path;
+    gchar                    *uri;
+    gchar                    *mime_type;
+    /* where tumbler will put the thumbnail, and where versions before
+     * 0.7.0 put it */
+    gchar                    *thumbnail_path;
+    gchar                    *old_thumbnail_path;
+
+    /* TRUE once the file was sent to tumbler as part of request @handle */
+    gboolean                  in_flight;
+    guint                     handle;
+} XfdesktopThumbnailRequest;
+
 struct _XfdesktopThumbnailerPriv
 {
     DBusGProxy               *proxy;
 
-    GSList                   *queue;
+    /* path -> XfdesktopThumbnailRequest, for every file we're waiting on */
+    GHashTable               *requests;
+    /* uri -> the same requests, to match what tumbler sends back */
+    GHashTable               *requests_by_uri;
+    /* paths that haven't been sent yet, oldest first.  may still hold
+     * paths that were dequeued in the meantime; those get skipped. */
+    GPtrArray                *pending;
+    /* handles of the requests tumbler hasn't finished yet */
+    GSList                   *handles;
+
     gchar                   **supported_mimetypes;
     gboolean                  big_thumbnails;
-    gint                      handle;
 
     gint                      request_timer_id;
 };
 
+static void
+xfdesktop_thumbnail_request_free(XfdesktopThumbnailRequest *request)
+{
+    g_free(request->path);
+    g_free(request->uri);
+    g_free(request->mime_type);
+    g_free(request->thumbnail_path);
+    g_free(request->old_thumbnail_path);
+    g_slice_free(XfdesktopThumbnailRequest, request);
+}
+
 static void
 xfdesktop_thumbnailer_init(GObject *object)
 {
@@ -122,6 +156,12 @@ xfdesktop_thumbnailer_init(GObject *object)
 
     thumbnailer->priv = g_new0(XfdesktopThumbnailerPriv, 1);
 
+    /* both are keyed by strings the request owns */
+    thumbnailer->priv->requests = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+                                                        (GDestroyNotify)xfdesktop_thumbnail_request_free);
+    thumbnailer->priv->requests_by_uri = g_hash_table_new(g_str_hash, g_str_equal);
+    thumbnailer->priv->pending = g_ptr_array_new_with_free_func(g_free);
+
     connection = dbus_g_bus_get(DBUS_BUS_SESSION, NULL);
 
     if(connection) {
@@ -217,9 +257,17 @@ xfdesktop_thumbnailer_dispose(GObject *object)
     XfdesktopThumbnailer *thumbnailer = XFDESKTOP_THUMBNAILER(object);
 
     if(thumbnailer->priv) {
+        if(thumbnailer->priv->request_timer_id)
+            g_source_remove(thumbnailer->priv->request_timer_id);
+
         if(thumbnailer->priv->proxy)
             g_object_unref(thumbnailer->priv->proxy);
 
+        g_hash_table_destroy(thumbnailer->priv->requests_by_uri);
+        g_hash_table_destroy(thumbnailer->priv->requests);
+        g_ptr_array_free(thumbnailer->priv->pending, TRUE);
+        g_slist_free(thumbnailer->priv->handles);
+
         if(thumbnailer->priv->supported_mimetypes)
             g_strfreev(thumbnailer->priv->supported_mimetypes);
 
@@ -268,12 +316,28 @@ gboolean xfdesktop_thumbnailer_service_available(XfdesktopThumbnailer *thumbnail
     return TRUE;
 }
 
+static gboolean
+xfdesktop_thumbnailer_mime_type_is_supported(XfdesktopThumbnailer *thumbnailer,
+                                             const gchar *mime_type)
+{
+    guint n;
+
+    if(thumbnailer->priv->supported_mimetypes != NULL) {
+        for(n = 0; thumbnailer->priv->supported_mimetypes[n] != NULL; ++n) {
+            if(g_content_type_is_a (mime_type, thumbnailer->priv->supported_mimetypes[n]))
+                return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
 gboolean
 xfdesktop_thumbnailer_is_supported(XfdesktopThumbnailer *thumbnailer,
                                    gchar *file)
 {
-    guint        n;
     gchar       *mime_type = NULL;
+    gboolean     supported;
 
     g_return_val_if_fail(XFDESKTOP_IS_THUMBNAILER(thumbnailer), FALSE);
     g_return_val_if_fail(file != NULL, FALSE);
@@ -285,17 +349,85 @@ xfdesktop_thumbnailer_is_supported(XfdesktopThumbnailer *thumbnailer,
         return FALSE;
     }
 
-    if(thumbnailer->priv->supported_mimetypes != NULL) {
-        for(n = 0; thumbnailer->priv->supported_mimetypes[n] != NULL; ++n) {
-            if(g_content_type_is_a (mime_type, thumbnailer->priv->supported_mimetypes[n])) {
-                g_free(mime_type);
-                return TRUE;
-            }
-        }
-    }
+    supported = xfdesktop_thumbnailer_mime_type_is_supported(thumbnailer,
+                                                             mime_type);
 
     g_free(mime_type);
-    return FALSE;
+    return supported;
+}
+
+/* works out everything Ready needs up front, so matching the reply is
+ * just a lookup */
+static XfdesktopThumbnailRequest *
+xfdesktop_thumbnailer_request_new(XfdesktopThumbnailer *thumbnailer,
+                                  const gchar *path,
+                                  gchar *mime_type)
+{
+    XfdesktopThumbnailRequest *request = g_slice_new0(XfdesktopThumbnailRequest);
+    GFile *file = g_file_new_for_path(path);
+    const gchar *thumbnail_flavor;
+    gchar *f_uri_checksum, *filename;
+
+    request->path = g_strdup(path);
+    request->uri = g_file_get_uri(file);
+    request->mime_type = mime_type;
+
+    if(thumbnailer->priv->big_thumbnails == TRUE)
+        thumbnail_flavor = "large";
+    else
+        thumbnail_flavor = "normal";
+
+    /* The thumbnail is in the format/location
+     * $XDG_CACHE_HOME/thumbnails/(nromal|large)/MD5_Hash_Of_URI.png
+     * for version 0.8.0 if XDG_CACHE_HOME is defined, otherwise
+     * /homedir/.thumbnails/(normal|large)/MD5_Hash_Of_URI.png
+     * will be used, which is also always used for versions prior
+     * to 0.7.0.
+     */
+    f_uri_checksum = g_compute_checksum_for_string(G_CHECKSUM_MD5,
+                                                   request->uri,
+                                                   strlen(request->uri));
+    filename = g_strconcat(f_uri_checksum, ".png", NULL);
+
+    request->thumbnail_path = g_build_path("/", g_get_user_cache_dir(),
+                                           "thumbnails", thumbnail_flavor,
+                                           filename, NULL);
+    request->old_thumbnail_path = g_build_path("/", g_get_home_dir(),
+                                               ".thumbnails", thumbnail_flavor,
+                                               filename, NULL);
+
+    g_free(filename);
+    g_free(f_uri_checksum);
+    g_object_unref(file);
+
+    return request;
+}
+
+static void
+xfdesktop_thumbnailer_forget_request(XfdesktopThumbnailer *thumbnailer,
+                                     XfdesktopThumbnailRequest *request)
+{
+    g_hash_table_remove(thumbnailer->priv->requests_by_uri, request->uri);
+    /* frees the request */
+    g_hash_table_remove(thumbnailer->priv->requests, request->path);
+}
+
+/* forgets the files sent with @handle that never got a Ready, so they can
+ * be asked for again */
+static void
+xfdesktop_thumbnailer_forget_failed_requests(XfdesktopThumbnailer *thumbnailer,
+                                             guint handle)
+{
+    GHashTableIter iter;
+    XfdesktopThumbnailRequest *request;
+
+    g_hash_table_iter_init(&iter, thumbnailer->priv->requests);
+    while(g_hash_table_iter_next(&iter, NULL, (gpointer *)&request)) {
+        if(request->in_flight && request->handle == handle) {
+            g_hash_table_remove(thumbnailer->priv->requests_by_uri, request->uri);
+            g_hash_table_iter_remove(&iter);
+        }
+    }
 }
 
 /**
@@ -311,37 +443,33 @@ gboolean
 xfdesktop_thumbnailer_queue_thumbnail(XfdesktopThumbnailer *thumbnailer,
                                       gchar *file)
 {
+    XfdesktopThumbnailRequest *request;
+    gchar *mime_type;
+
     g_return_val_if_fail(XFDESKTOP_IS_THUMBNAILER(thumbnailer), FALSE);
     g_return_val_if_fail(file != NULL, FALSE);
 
-    if(!xfdesktop_thumbnailer_is_supported(thumbnailer, file)) {
+    /* already waiting on it, either here or with tumbler */
+    if(g_hash_table_lookup(thumbnailer->priv->requests, file))
+        return TRUE;
+
+    mime_type = xfdesktop_get_file_mimetype(file);
+    if(mime_type == NULL
+       || !xfdesktop_thumbnailer_mime_type_is_supported(thumbnailer, mime_type))
+    {
         DBG("file: %s not supported", file);
+        g_free(mime_type);
         return FALSE;
     }
-    if(thumbnailer->priv->request_timer_id) {
-        g_source_remove(thumbnailer->priv->request_timer_id);
 
-        if(thumbnailer->priv->handle && thumbnailer->priv->proxy != NULL) {
-            if(dbus_g_proxy_call(thumbnailer->priv->proxy,
-                                 "Dequeue",
-                                 NULL,
-                                 G_TYPE_UINT, thumbnailer->priv->handle,
-                                 G_TYPE_INVALID) == FALSE)
-            {
-                /* If this fails it usually means there's a thumbnail already
-                 * being processed, no big deal */
-                DBG("Dequeue of thumbnailer->priv->handle: %d failed",
-                    thumbnailer->priv->handle);
-            }
+    request = xfdesktop_thumbnailer_request_new(thumbnailer, file, mime_type);
+    g_hash_table_insert(thumbnailer->priv->requests, request->path, request);
+    g_hash_table_insert(thumbnailer->priv->requests_by_uri, request->uri, request);
+    g_ptr_array_add(thumbnailer->priv->pending, g_strdup(file));
 
-            thumbnailer->priv->handle = 0;
-        }
-    }
-
-    if(g_slist_find(thumbnailer->priv->queue, file) == NULL) {
-        thumbnailer->priv->queue = g_slist_prepend(thumbnailer->priv->queue,
-                                                   g_strdup(file));
-    }
+    /* wait for more files so they all go out in one request */
+    if(thumbnailer->priv->request_timer_id)
+        g_source_remove(thumbnailer->priv->request_timer_id);
 
     thumbnailer->priv->request_timer_id = g_timeout_add_full(
                         G_PRIORITY_LOW,
@@ -353,143 +481,151 @@ xfdesktop_thumbnailer_queue_thumbnail(XfdesktopThumbnailer *thumbnailer,
     return TRUE;
 }
 
-static void
-xfdesktop_thumbnailer_dequeue_foreach(gpointer data, gpointer user_data)
-{
-    xfdesktop_thumbnailer_dequeue_thumbnail(user_data, data);
-}
-
 /**
  * xfdesktop_thumbnailer_dequeue_thumbnail:
  * 
  * Removes a file from the list of pending thumbnail creations.
  * This is not guaranteed to always remove the file, if processing
- * of that thumbnail has started it won't stop.
+ * of that thumbnail has started it won't stop.  No "thumbnail-ready"
+ * signal will be emitted for it though.
  */
 void
 xfdesktop_thumbnailer_dequeue_thumbnail(XfdesktopThumbnailer *thumbnailer,
                                         gchar *file)
 {
-    GSList *item;
+    XfdesktopThumbnailRequest *request;
 
     g_return_if_fail(XFDESKTOP_IS_THUMBNAILER(thumbnailer));
     g_return_if_fail(file != NULL);
 
+    /* its entry in the pending array is skipped when the request goes out */
+    request = g_hash_table_lookup(thumbnailer->priv->requests, file);
+    if(request)
+        xfdesktop_thumbnailer_forget_request(thumbnailer, request);
+}
+
+void xfdesktop_thumbnailer_dequeue_all_thumbnails(XfdesktopThumbnailer *thumbnailer)
+{
+    GSList *iter;
+
+    g_return_if_fail(XFDESKTOP_IS_THUMBNAILER(thumbnailer));
+
     if(thumbnailer->priv->request_timer_id) {
         g_source_remove(thumbnailer->priv->request_timer_id);
+        thumbnailer->priv->request_timer_id = 0;
+    }
 
-        if(thumbnailer->priv->handle && thumbnailer->priv->proxy) {
-            if(dbus_g_proxy_call(thumbnailer->priv->proxy,
-                                 "Dequeue",
-                                 NULL,
-                                 G_TYPE_UINT, thumbnailer->priv->handle,
-                                 G_TYPE_INVALID) == FALSE)
-            {
-                /* If this fails it usually means there's a thumbnail already
-                 * being processed, no big deal */
-                DBG("Dequeue of thumbnailer->priv->handle: %d failed",
-                    thumbnailer->priv->handle);
-            }
+    /* nobody wants any of what tumbler is working on either */
+    for(iter = thumbnailer->priv->handles; iter; iter = iter->next) {
+        if(thumbnailer->priv->proxy == NULL)
+            break;
+
+        if(dbus_g_proxy_call(thumbnailer->priv->proxy,
+                             "Dequeue",
+                             NULL,
+                             G_TYPE_UINT, GPOINTER_TO_UINT(iter->data),
+                             G_TYPE_INVALID) == FALSE)
+        {
+            /* If this fails it usually means there's a thumbnail already
+             * being processed, no big deal */
+            DBG("Dequeue of handle: %u failed", GPOINTER_TO_UINT(iter->data));
         }
-        thumbnailer->priv->handle = 0;
     }
 
-    item = g_slist_find(thumbnailer->priv->queue, file);
-    if(item != NULL) {
-        g_free(item->data);
-        thumbnailer->priv->queue = g_slist_remove(thumbnailer->priv->queue,
-                                                  file);
-    }
+    g_slist_free(thumbnailer->priv->handles);
+    thumbnailer->priv->handles = NULL;
 
-    thumbnailer->priv->request_timer_id = g_timeout_add_full(
-                        G_PRIORITY_LOW,
-                        300,
-                        (GSourceFunc)xfdesktop_thumbnailer_queue_request_timer,
-                        thumbnailer,
-                        NULL);
-}
-
-void xfdesktop_thumbnailer_dequeue_all_thumbnails(XfdesktopThumbnailer *thumbnailer)
-{
-    g_return_if_fail(XFDESKTOP_IS_THUMBNAILER(thumbnailer));
-
-    g_slist_foreach(thumbnailer->priv->queue, (GFunc)xfdesktop_thumbnailer_dequeue_foreach, thumbnailer);
+    g_hash_table_remove_all(thumbnailer->priv->requests_by_uri);
+    g_hash_table_remove_all(thumbnailer->priv->requests);
+    g_ptr_array_set_size(thumbnailer->priv->pending, 0);
 }
 
 static gboolean
 xfdesktop_thumbnailer_queue_request_timer(XfdesktopThumbnailer *thumbnailer)
 {
-    gchar **uris;
-    gchar **mimetypes;
-    GSList *iter;
-    gint i = 0;
-    GFile *file;
+    GPtrArray *pending;
+    XfdesktopThumbnailRequest *request;
+    const gchar **uris;
+    const gchar **mimetypes;
+    guint i, n = 0;
+    guint handle = 0;
     GError *error = NULL;
     gchar *thumbnail_flavor;
 
     g_return_val_if_fail(XFDESKTOP_IS_THUMBNAILER(thumbnailer), FALSE);
 
-    uris = g_new0(gchar *,
-                  g_slist_length(thumbnailer->priv->queue) + 1);
-    mimetypes = g_new0(gchar *,
-                       g_slist_length (thumbnailer->priv->queue) + 1);
+    thumbnailer->priv->request_timer_id = 0;
 
-    iter = thumbnailer->priv->queue;
-    while(iter) {
-        if(iter->data) {
-            file = g_file_new_for_path(iter->data);
-            uris[i] = g_file_get_uri(file);
-            mimetypes[i] = xfdesktop_get_file_mimetype(iter->data);
+    pending = thumbnailer->priv->pending;
 
-            g_object_unref(file);
-        }
-        iter = g_slist_next(iter);
-        i++;
-    }
+    /* the strings belong to the requests */
+    uris = g_new0(const gchar *, pending->len + 1);
+    mimetypes = g_new0(const gchar *, pending->len + 1);
 
-    if(thumbnailer->priv->big_thumbnails == TRUE)
-        thumbnail_flavor = "large";
-    else
-        thumbnail_flavor = "normal";
+    /* everything that's still wanted and wasn't sent yet; a path can be in
+     * here twice if it was dequeued and queued again */
+    for(i = 0; i < pending->len; ++i) {
+        request = g_hash_table_lookup(thumbnailer->priv->requests,
+                                      g_ptr_array_index(pending, i));
+        if(!request || request->in_flight)
+            continue;
 
-    if(thumbnailer->priv->proxy != NULL) {
-        if(dbus_g_proxy_call(thumbnailer->priv->proxy,
-                             "Queue",
-                             &error,
-                             G_TYPE_STRV, uris,
-                             G_TYPE_STRV, mimetypes,
-                             G_TYPE_STRING, thumbnail_flavor,
-                             G_TYPE_STRING, "default",
-                             G_TYPE_UINT, 0,
-                             G_TYPE_INVALID,
-                             G_TYPE_UINT, &thumbnailer->priv->handle,
-                             G_TYPE_INVALID) == FALSE)
+        request->in_flight = TRUE;
+
+        uris[n] = request->uri;
+        mimetypes[n] = request->mime_type;
+        n++;
+    }
+
+    if(n > 0) {
+        if(thumbnailer->priv->big_thumbnails == TRUE)
+            thumbnail_flavor = "large";
+        else
+            thumbnail_flavor = "normal";
+
+        if(thumbnailer->priv->proxy == NULL
+           || dbus_g_proxy_call(thumbnailer->priv->proxy,
+                                "Queue",
+                                &error,
+                                G_TYPE_STRV, uris,
+                                G_TYPE_STRV, mimetypes,
+                                G_TYPE_STRING, thumbnail_flavor,
+                                G_TYPE_STRING, "default",
+                                G_TYPE_UINT, 0,
+                                G_TYPE_INVALID,
+                                G_TYPE_UINT, &handle,
+                                G_TYPE_INVALID) == FALSE)
         {
             if(error != NULL)
                 g_warning("DBUS-call failed: %s", error->message);
+            handle = 0;
+        } else {
+            thumbnailer->priv->handles = g_slist_prepend(thumbnailer->priv->handles,
+                                                         GUINT_TO_POINTER(handle));
         }
-    }
 
-    /* Free the memory */
-    i = 0;
-    iter = thumbnailer->priv->queue;
-    while(iter) {
-        if(iter->data) {
-            g_free(uris[i]);
-            g_free(mimetypes[i]);
+        /* note which request the files went out with */
+        for(i = 0; i < pending->len; ++i) {
+            request = g_hash_table_lookup(thumbnailer->priv->requests,
+                                          g_ptr_array_index(pending, i));
+            if(request && request->in_flight && request->handle == 0)
+                request->handle = handle;
         }
-        iter = g_slist_next(iter);
-        i++;
+
+        /* nothing is coming back for these, so they can be asked for
+         * again later */
+        if(handle == 0)
+            xfdesktop_thumbnailer_forget_failed_requests(thumbnailer, 0);
     }
 
+    g_ptr_array_set_size(pending, 0);
+
     g_free(uris);
     g_free(mimetypes);
 
     if(error)
         g_error_free(error);
 
-    thumbnailer->priv->request_timer_id = 0;
-
     return FALSE;
 }
 
@@ -502,7 +638,11 @@ xfdesktop_thumbnailer_request_finished_dbus(DBusGProxy *proxy,
 
     g_return_if_fail(XFDESKTOP_IS_THUMBNAILER(thumbnailer));
 
-    thumbnailer->priv->handle = 0;
+    thumbnailer->priv->handles = g_slist_remove(thumbnailer->priv->handles,
+                                                GUINT_TO_POINTER(handle));
+
+    /* whatever didn't get a Ready failed */
+    xfdesktop_thumbnailer_forget_failed_requests(thumbnailer, handle);
 }
 
 static void
@@ -512,82 +652,41 @@ xfdesktop_thumbnailer_thumbnail_ready_dbus(DBusGProxy *proxy,
                                            gpointer data)
 {
     XfdesktopThumbnailer *thumbnailer = XFDESKTOP_THUMBNAILER(data);
-    gchar *thumbnail_location;
-    GFile *file;
-    GSList *iter = thumbnailer->priv->queue;
-    gchar *f_uri, *f_uri_checksum, *filename, *temp;
-    gchar *thumbnail_flavor;
-    gint x = 0;
+    XfdesktopThumbnailRequest *request;
+    const gchar *thumbnail_location;
+    gint x;
 
     g_return_if_fail(XFDESKTOP_IS_THUMBNAILER(thumbnailer));
 
-    while(iter) {
-        if((uri[x] == NULL) || (iter->data == NULL)) {
-            break;
-        }
+    for(x = 0; uri[x] != NULL; ++x) {
+        request = g_hash_table_lookup(thumbnailer->priv->requests_by_uri, uri[x]);
 
-        file = g_file_new_for_path(iter->data);
-        f_uri = g_file_get_uri(file);
-
-        if(strcmp (uri[x], f_uri) == 0) {
-            /* The thumbnail is in the format/location
-             * $XDG_CACHE_HOME/thumbnails/(nromal|large)/MD5_Hash_Of_URI.png
-             * for version 0.8.0 if XDG_CACHE_HOME is defined, otherwise
-             * /homedir/.thumbnails/(normal|large)/MD5_Hash_Of_URI.png
-             * will be used, which is also always used for versions prior
-             * to 0.7.0.
-             */
-            f_uri_checksum = g_compute_checksum_for_string(G_CHECKSUM_MD5,
-                                                           f_uri, strlen (f_uri));
-
-            if(thumbnailer->priv->big_thumbnails == TRUE)
-                thumbnail_flavor = "large";
-            else
-                thumbnail_flavor = "normal";
-
-            filename = g_strconcat(f_uri_checksum, ".png", NULL);
-
-            /* build and check if the thumbnail is in the new location */
-            thumbnail_location = g_build_path("/", g_get_user_cache_dir(),
-                                              "thumbnails", thumbnail_flavor,
-                                              filename, NULL);
-
-            if(!g_file_test(thumbnail_location, G_FILE_TEST_EXISTS)) {
-                /* Fallback to old version */
-                g_free(thumbnail_location);
-
-                thumbnail_location = g_build_path("/", g_get_home_dir(),
-                                                  ".thumbnails", thumbnail_flavor,
-                                                  filename, NULL);
-            }
+        /* not ours, or dequeued since */
+        if(!request)
+            continue;
 
-            DBG("thumbnail-ready src: %s thumbnail: %s",
-                (char*)iter->data,
-                thumbnail_location);
+        /* check if the thumbnail is in the new location, else fall back to
+         * the old one */
+        if(g_file_test(request->thumbnail_path, G_FILE_TEST_EXISTS))
+            thumbnail_location = request->thumbnail_path;
+        else
+            thumbnail_location = request->old_thumbnail_path;
 
-            g_signal_emit(G_OBJECT(thumbnailer),
-                          thumbnailer_signals[THUMBNAIL_READY],
-                          0,
-                          iter->data,
-                          thumbnail_location);
+        DBG("thumbnail-ready src: %s thumbnail: %s",
+            request->path,
+            thumbnail_location);
 
-            temp = iter->data;
-            thumbnailer->priv->queue = g_slist_remove(thumbnailer->priv->queue,
-                                                      temp);
+        /* handlers may queue the file again, which needs a fresh request */
+        g_hash_table_steal(thumbnailer->priv->requests_by_uri, request->uri);
+        g_hash_table_steal(thumbnailer->priv->requests, request->path);
 
-            iter = thumbnailer->priv->queue;
-            x++;
+        g_signal_emit(G_OBJECT(thumbnailer),
+                      thumbnailer_signals[THUMBNAIL_READY],
+                      0,
+                      request->path,
+                      thumbnail_location);
 
-            g_free(filename);
-            g_free(f_uri_checksum);
-            g_free(thumbnail_location);
-            g_free(temp);
-        } else {
-            iter = g_slist_next(iter);
-        }
-        
-        g_object_unref(file);
-        g_free(f_uri);
+        xfdesktop_thumbnail_request_free(request);
     }
 }
 
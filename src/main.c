@@ -78,6 +78,11 @@ main(int argc, char **argv)
     xfce_textdomain(GETTEXT_PACKAGE, LOCALEDIR, "UTF-8");
 
 #ifdef ENABLE_FILE_ICONS
+#if !GLIB_CHECK_VERSION (2, 32, 0)
+    /* file icons are decoded on worker threads */
+    if(!g_thread_supported())
+        g_thread_init(NULL);
+#endif
     dbus_g_thread_init();
 #endif
 
@@ -39,6 +39,7 @@
 #include "xfdesktop-file-icon.h"
 #include "xfdesktop-file-icon-manager.h"
 #include "xfdesktop-file-utils.h"
+#include "xfdesktop-marshal.h"
 
 #ifndef I_
 #define I_(str)  g_intern_static_string(str)
@@ -54,6 +55,7 @@ enum
 enum
 {
   CHANGED,
+  CUT_CHANGED,
   LAST_SIGNAL,
 };
 
@@ -95,6 +97,7 @@ static void xfdesktop_clipboard_manager_clear_callback    (GtkClipboard
 static void xfdesktop_clipboard_manager_transfer_files    (XfdesktopClipboardManager      *manager,
                                                            gboolean                        copy,
                                                            GList                          *files);
+static void xfdesktop_clipboard_manager_update_cut_files  (XfdesktopClipboardManager      *manager);
 
 
 
@@ -102,7 +105,10 @@ struct _XfdesktopClipboardManagerClass
 {
   GObjectClass __parent__;
 
-  void (*changed) (XfdesktopClipboardManager *manager);
+  void (*changed)     (XfdesktopClipboardManager *manager);
+  void (*cut_changed) (XfdesktopClipboardManager *manager,
+                       GList                     *added,
+                       GList                     *removed);
 };
 
 struct _XfdesktopClipboardManager
@@ -115,6 +121,9 @@ struct _XfdesktopClipboardManager
 
   gboolean      files_cutted;
   GList        *files;
+
+  /* GFiles listeners were last told are cut */
+  GHashTable   *cut_files;
 };
 
 typedef struct
@@ -208,6 +217,26 @@ xfdesktop_clipboard_manager_class_init (XfdesktopClipboardManagerClass *klass)
                   NULL, NULL,
                   g_cclosure_marshal_VOID__VOID,
                   G_TYPE_NONE, 0);
+
+  /**
+   * XfdesktopClipboardManager::cut-changed:
+   * @manager : a #XfdesktopClipboardManager.
+   * @added   : a #GList of #GFile<!---->s that are now cut.
+   * @removed : a #GList of #GFile<!---->s that no longer are.
+   *
+   * This signal is emitted right before #XfdesktopClipboardManager::changed
+   * whenever the set of cut files changes, so listeners only need to
+   * look at files whose state actually flipped.
+   **/
+  manager_signals[CUT_CHANGED] =
+    g_signal_new (I_("cut-changed"),
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_FIRST,
+                  G_STRUCT_OFFSET (XfdesktopClipboardManagerClass, cut_changed),
+                  NULL, NULL,
+                  xfdesktop_marshal_VOID__POINTER_POINTER,
+                  G_TYPE_NONE, 2,
+                  G_TYPE_POINTER, G_TYPE_POINTER);
 }
 
 
@@ -216,6 +245,8 @@ static void
 xfdesktop_clipboard_manager_init (XfdesktopClipboardManager *manager)
 {
   manager->x_special_gnome_copied_files = gdk_atom_intern ("x-special/gnome-copied-files", FALSE);
+  manager->cut_files = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal,
+                                              g_object_unref, NULL);
 }
 
 
@@ -236,6 +267,8 @@ xfdesktop_clipboard_manager_finalize (GObject *object)
     }
   g_list_free (manager->files);
 
+  g_hash_table_destroy (manager->cut_files);
+
   /* disconnect from the clipboard */
   g_signal_handlers_disconnect_by_func (G_OBJECT (manager->clipboard),
                                         xfdesktop_clipboard_manager_owner_changed,
@@ -444,6 +477,7 @@ xfdesktop_clipboard_manager_targets_received (GtkClipboard     *clipboard,
     }
   
   /* notify listeners that we have a new clipboard state */
+  xfdesktop_clipboard_manager_update_cut_files (manager);
   g_signal_emit (G_OBJECT (manager), manager_signals[CHANGED], 0);
   g_object_notify (G_OBJECT (manager), "can-paste");
 
@@ -576,6 +610,52 @@ xfdesktop_clipboard_manager_transfer_files (XfdesktopClipboardManager *manager,
 
 
 
+static void
+xfdesktop_clipboard_manager_update_cut_files (XfdesktopClipboardManager *manager)
+{
+  GHashTable     *cut_files;
+  GHashTableIter  iter;
+  GList          *added = NULL;
+  GList          *removed = NULL;
+  GList          *lp;
+  GFile          *gfile;
+
+  cut_files = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal,
+                                     g_object_unref, NULL);
+
+  /* what's cut now; anything that wasn't before was added */
+  if (manager->files_cutted)
+    {
+      for (lp = manager->files; lp != NULL; lp = lp->next)
+        {
+          gfile = xfdesktop_file_icon_peek_file (lp->data);
+          if (G_UNLIKELY (gfile == NULL || g_hash_table_lookup (cut_files, gfile) != NULL))
+            continue;
+
+          g_hash_table_insert (cut_files, g_object_ref (gfile), gfile);
+          if (!g_hash_table_remove (manager->cut_files, gfile))
+            added = g_list_prepend (added, gfile);
+        }
+    }
+
+  /* and whatever is left of the old set was removed */
+  g_hash_table_iter_init (&iter, manager->cut_files);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &gfile, NULL))
+    removed = g_list_prepend (removed, gfile);
+
+  if (added != NULL || removed != NULL)
+    g_signal_emit (G_OBJECT (manager), manager_signals[CUT_CHANGED], 0, added, removed);
+
+  g_list_free (added);
+  g_list_free (removed);
+
+  /* the old set holds the references for the removed files until now */
+  g_hash_table_destroy (manager->cut_files);
+  manager->cut_files = cut_files;
+}
+
+
+
 /**
  * xfdesktop_clipboard_manager_get_for_display:
  * @display : a #GdkDisplay.
@@ -630,7 +710,8 @@ xfdesktop_clipboard_manager_get_for_display (GdkDisplay *display)
  * @manager : a #XfdesktopClipboardManager.
  * @file    : a #XfdesktopFile.
  *
- * Checks whether @file was cutted to the given @manager earlier.
+ * Checks whether @file was cutted to the given @manager earlier,
+ * as last announced by #XfdesktopClipboardManager::cut-changed.
  *
  * Return value: %TRUE if @file is on the cutted list of @manager.
  **/
@@ -638,10 +719,14 @@ gboolean
 xfdesktop_clipboard_manager_has_cutted_file (XfdesktopClipboardManager *manager,
                                              const XfdesktopFileIcon       *file)
 {
+  GFile *gfile;
+
   g_return_val_if_fail (XFDESKTOP_IS_CLIPBOARD_MANAGER (manager), FALSE);
   g_return_val_if_fail (XFDESKTOP_IS_FILE_ICON (file), FALSE);
 
-  return (manager->files_cutted && g_list_find (manager->files, file) != NULL);
+  gfile = xfdesktop_file_icon_peek_file ((XfdesktopFileIcon *) file);
+
+  return (gfile != NULL && g_hash_table_lookup (manager->cut_files, gfile) != NULL);
 }
 
 
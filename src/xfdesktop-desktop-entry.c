@@ -0,0 +1,299 @@
+/*
+ *  xfdesktop - xfce4's desktop manager
+ *
+ *  Copyright (c) 2014 The Xfce Development Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software Foundation,
+ *  Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gio/gio.h>
+
+#include <libxfce4util/libxfce4util.h>
+
+#include "xfdesktop-desktop-entry.h"
+
+typedef struct
+{
+    XfdesktopDesktopEntry entry;
+    guint64 mtime;
+    goffset size;
+    /* FALSE if the file couldn't be parsed, so we don't keep trying */
+    gboolean valid;
+} XfdesktopDesktopEntryCached;
+
+typedef struct
+{
+    GFile *file;
+    GFileInfo *info;
+    GCancellable *cancellable;
+    XfdesktopDesktopEntryFunc func;
+    gpointer user_data;
+} XfdesktopDesktopEntryLoad;
+
+/* uri -> XfdesktopDesktopEntryCached */
+static GHashTable *entry_cache = NULL;
+
+
+static void
+xfdesktop_desktop_entry_cached_free(XfdesktopDesktopEntryCached *cached)
+{
+    g_free(cached->entry.name);
+    g_free(cached->entry.icon);
+    g_free(cached->entry.comment);
+    g_free(cached->entry.type);
+    g_free(cached->entry.try_exec);
+    g_strfreev(cached->entry.only_show_in);
+    g_strfreev(cached->entry.not_show_in);
+    g_slice_free(XfdesktopDesktopEntryCached, cached);
+}
+
+static gboolean
+xfdesktop_desktop_entry_get_stamp(GFileInfo *info,
+                                  guint64 *mtime,
+                                  goffset *size)
+{
+    if(!g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_TIME_MODIFIED)
+       || !g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_STANDARD_SIZE))
+    {
+        return FALSE;
+    }
+
+    *mtime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+    *size = g_file_info_get_size(info);
+
+    return TRUE;
+}
+
+static XfdesktopDesktopEntryCached *
+xfdesktop_desktop_entry_parse(const gchar *contents,
+                              gsize length)
+{
+    XfdesktopDesktopEntryCached *cached = g_slice_new0(XfdesktopDesktopEntryCached);
+    XfdesktopDesktopEntry *entry = &cached->entry;
+    GKeyFile *key_file = g_key_file_new();
+
+    if(length > 0
+       && g_key_file_load_from_data(key_file, contents, length,
+                                    G_KEY_FILE_NONE, NULL))
+    {
+        entry->name = g_key_file_get_locale_string(key_file,
+                                                   G_KEY_FILE_DESKTOP_GROUP,
+                                                   G_KEY_FILE_DESKTOP_KEY_NAME,
+                                                   NULL, NULL);
+        entry->icon = g_key_file_get_string(key_file,
+                                            G_KEY_FILE_DESKTOP_GROUP,
+                                            G_KEY_FILE_DESKTOP_KEY_ICON,
+                                            NULL);
+        entry->comment = g_key_file_get_locale_string(key_file,
+                                                      G_KEY_FILE_DESKTOP_GROUP,
+                                                      G_KEY_FILE_DESKTOP_KEY_COMMENT,
+                                                      NULL, NULL);
+        entry->type = g_key_file_get_string(key_file,
+                                            G_KEY_FILE_DESKTOP_GROUP,
+                                            G_KEY_FILE_DESKTOP_KEY_TYPE,
+                                            NULL);
+        entry->try_exec = g_key_file_get_string(key_file,
+                                                G_KEY_FILE_DESKTOP_GROUP,
+                                                G_KEY_FILE_DESKTOP_KEY_TRY_EXEC,
+                                                NULL);
+        entry->only_show_in = g_key_file_get_string_list(key_file,
+                                                         G_KEY_FILE_DESKTOP_GROUP,
+                                                         G_KEY_FILE_DESKTOP_KEY_ONLY_SHOW_IN,
+                                                         NULL, NULL);
+        entry->not_show_in = g_key_file_get_string_list(key_file,
+                                                        G_KEY_FILE_DESKTOP_GROUP,
+                                                        G_KEY_FILE_DESKTOP_KEY_NOT_SHOW_IN,
+                                                        NULL, NULL);
+        entry->hidden = g_key_file_get_boolean(key_file,
+                                               G_KEY_FILE_DESKTOP_GROUP,
+                                               G_KEY_FILE_DESKTOP_KEY_HIDDEN,
+                                               NULL);
+        cached->valid = TRUE;
+    }
+
+    g_key_file_free(key_file);
+
+    return cached;
+}
+
+static const XfdesktopDesktopEntry *
+xfdesktop_desktop_entry_store(GFile *file,
+                              GFileInfo *info,
+                              XfdesktopDesktopEntryCached *cached)
+{
+    if(!xfdesktop_desktop_entry_get_stamp(info, &cached->mtime, &cached->size)) {
+        /* nothing to validate it against later, so it never matches a
+         * lookup; the caller can still use it until the next one */
+        cached->mtime = G_MAXUINT64;
+        cached->size = -1;
+    }
+
+    if(!entry_cache) {
+        entry_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                            (GDestroyNotify)xfdesktop_desktop_entry_cached_free);
+    }
+
+    g_hash_table_replace(entry_cache, g_file_get_uri(file), cached);
+
+    return cached->valid ? &cached->entry : NULL;
+}
+
+static XfdesktopDesktopEntryCached *
+xfdesktop_desktop_entry_find(GFile *file,
+                             GFileInfo *info)
+{
+    XfdesktopDesktopEntryCached *cached;
+    guint64 mtime;
+    goffset size;
+    gchar *uri;
+
+    if(!entry_cache || !xfdesktop_desktop_entry_get_stamp(info, &mtime, &size))
+        return NULL;
+
+    uri = g_file_get_uri(file);
+    cached = g_hash_table_lookup(entry_cache, uri);
+    g_free(uri);
+
+    if(cached && cached->mtime == mtime && cached->size == size)
+        return cached;
+
+    return NULL;
+}
+
+static void
+xfdesktop_desktop_entry_load_ready(GObject *source,
+                                   GAsyncResult *result,
+                                   gpointer user_data)
+{
+    XfdesktopDesktopEntryLoad *load = user_data;
+    const XfdesktopDesktopEntry *entry = NULL;
+    gchar *contents = NULL;
+    gsize length = 0;
+    GError *error = NULL;
+
+    if(g_file_load_contents_finish(G_FILE(source), result, &contents, &length,
+                                   NULL, &error))
+    {
+        entry = xfdesktop_desktop_entry_store(load->file, load->info,
+                                              xfdesktop_desktop_entry_parse(contents,
+                                                                            length));
+        g_free(contents);
+    }
+
+    load->func(load->file, load->info, entry, error, load->user_data);
+
+    if(error)
+        g_error_free(error);
+
+    g_object_unref(load->file);
+    g_object_unref(load->info);
+    if(load->cancellable)
+        g_object_unref(load->cancellable);
+    g_slice_free(XfdesktopDesktopEntryLoad, load);
+}
+
+
+/* returns the parsed entry for @file, reading it now if it's not cached or
+ * @info says it has changed.  the result belongs to the cache and is valid
+ * until the main loop runs again. */
+const XfdesktopDesktopEntry *
+xfdesktop_desktop_entry_lookup(GFile *file,
+                               GFileInfo *info)
+{
+    XfdesktopDesktopEntryCached *cached;
+    gchar *contents = NULL;
+    gsize length = 0;
+
+    g_return_val_if_fail(G_IS_FILE(file) && G_IS_FILE_INFO(info), NULL);
+
+    cached = xfdesktop_desktop_entry_find(file, info);
+    if(cached)
+        return cached->valid ? &cached->entry : NULL;
+
+    if(!g_file_load_contents(file, NULL, &contents, &length, NULL, NULL))
+        return NULL;
+
+    cached = xfdesktop_desktop_entry_parse(contents, length);
+    g_free(contents);
+
+    return xfdesktop_desktop_entry_store(file, info, cached);
+}
+
+/* reads @file in the background and calls @func once it's parsed, or right
+ * away if it's already cached.  @func is called even if @cancellable gets
+ * cancelled, so it can free @user_data. */
+void
+xfdesktop_desktop_entry_load_async(GFile *file,
+                                   GFileInfo *info,
+                                   GCancellable *cancellable,
+                                   XfdesktopDesktopEntryFunc func,
+                                   gpointer user_data)
+{
+    XfdesktopDesktopEntryCached *cached;
+    XfdesktopDesktopEntryLoad *load;
+
+    g_return_if_fail(G_IS_FILE(file) && G_IS_FILE_INFO(info) && func);
+
+    cached = xfdesktop_desktop_entry_find(file, info);
+    if(cached) {
+        func(file, info, cached->valid ? &cached->entry : NULL, NULL, user_data);
+        return;
+    }
+
+    load = g_slice_new0(XfdesktopDesktopEntryLoad);
+    load->file = g_object_ref(file);
+    load->info = g_object_ref(info);
+    load->cancellable = cancellable ? g_object_ref(cancellable) : NULL;
+    load->func = func;
+    load->user_data = user_data;
+
+    g_file_load_contents_async(file, cancellable,
+                               xfdesktop_desktop_entry_load_ready, load);
+}
+
+/* whether a launcher wants to be shown in Xfce at all (bug #4022) */
+gboolean
+xfdesktop_desktop_entry_should_show(const XfdesktopDesktopEntry *entry)
+{
+    gint i;
+
+    if(!entry)
+        return TRUE;
+
+    if(entry->hidden)
+        return FALSE;
+
+    if(entry->only_show_in) {
+        for(i = 0; entry->only_show_in[i]; ++i) {
+            if(!g_strcmp0(entry->only_show_in[i], "XFCE"))
+                break;
+        }
+        if(!entry->only_show_in[i])
+            return FALSE;
+    }
+
+    if(entry->not_show_in) {
+        for(i = 0; entry->not_show_in[i]; ++i) {
+            if(!g_strcmp0(entry->not_show_in[i], "XFCE"))
+                return FALSE;
+        }
+    }
+
+    return TRUE;
+}
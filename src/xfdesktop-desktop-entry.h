@@ -0,0 +1,64 @@
+/*
+ *  xfdesktop - xfce4's desktop manager
+ *
+ *  Copyright (c) 2014 The Xfce Development Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software Foundation,
+ *  Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __XFDESKTOP_DESKTOP_ENTRY_H__
+#define __XFDESKTOP_DESKTOP_ENTRY_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* the parts of a .desktop file the desktop cares about.  each file is
+ * parsed once and kept for as long as its mtime and size stay the same.
+ * Name and Comment are already localized. */
+typedef struct
+{
+    gchar *name;
+    gchar *icon;
+    gchar *comment;
+    gchar *type;
+    gchar *try_exec;
+    gchar **only_show_in;
+    gchar **not_show_in;
+    gboolean hidden;
+} XfdesktopDesktopEntry;
+
+/* @entry is NULL if the file couldn't be read or parsed; @error says why
+ * it couldn't be read, and is NULL otherwise */
+typedef void (*XfdesktopDesktopEntryFunc)(GFile *file,
+                                          GFileInfo *info,
+                                          const XfdesktopDesktopEntry *entry,
+                                          const GError *error,
+                                          gpointer user_data);
+
+const XfdesktopDesktopEntry *xfdesktop_desktop_entry_lookup(GFile *file,
+                                                            GFileInfo *info);
+
+void xfdesktop_desktop_entry_load_async(GFile *file,
+                                        GFileInfo *info,
+                                        GCancellable *cancellable,
+                                        XfdesktopDesktopEntryFunc func,
+                                        gpointer user_data);
+
+gboolean xfdesktop_desktop_entry_should_show(const XfdesktopDesktopEntry *entry);
+
+G_END_DECLS
+
+#endif  /* __XFDESKTOP_DESKTOP_ENTRY_H__ */
@@ -62,11 +62,15 @@
 #include "xfce-desktop.h"
 #include "xfdesktop-clipboard-manager.h"
 #include "xfdesktop-common.h"
+#include "xfdesktop-desktop-entry.h"
 #include "xfdesktop-file-icon.h"
 #include "xfdesktop-file-icon-manager.h"
 #include "xfdesktop-file-utils.h"
+#include "xfdesktop-folder-cover.h"
+#include "xfdesktop-folder-watcher.h"
 #include "xfdesktop-file-manager-proxy.h"
 #include "xfdesktop-icon-view.h"
+#include "xfdesktop-position-store.h"
 #include "xfdesktop-regular-file-icon.h"
 #include "xfdesktop-special-file-icon.h"
 #include "xfdesktop-trash-proxy.h"
@@ -77,8 +81,71 @@
 #include <libxfce4ui/libxfce4ui.h>
 
 #define SAVE_DELAY  1000
+/* how long (in microseconds) each idle may spend moving icons from the
+ * pending queue into the icon view */
+#define PENDING_ICONS_BUDGET  4000
+/* icons handed to the icon view per xfdesktop_icon_view_add_items() call */
+#define PENDING_ICONS_CHUNK   64
+/* the desktop folder is read a few files at a time at first so the first
+ * icons show up quickly, with the batch doubling (or halving) depending on
+ * whether the previous one came back within ENUMERATE_LATENCY usec */
+#define ENUMERATE_BATCH_MIN   8
+#define ENUMERATE_BATCH_MAX   256
+#define ENUMERATE_LATENCY     20000
+/* file monitor events are collected for this long (in ms) and then
+ * handled together */
+#define FILE_EVENT_DELAY      100
 #define BORDER         8
 
+typedef enum
+{
+    XFDESKTOP_FILE_EVENT_CREATED = 1,
+    XFDESKTOP_FILE_EVENT_CHANGED,
+    XFDESKTOP_FILE_EVENT_DELETED,
+    XFDESKTOP_FILE_EVENT_MOVED,
+} XfdesktopFileEventKind;
+
+typedef struct
+{
+    XfdesktopFileIconManager *fmanager;
+    GCancellable *cancellable;
+    GList *events;
+    gint outstanding;
+} XfdesktopFileEventBatch;
+
+typedef struct
+{
+    GFile *file;
+    /* where it went, for XFDESKTOP_FILE_EVENT_MOVED */
+    GFile *other_file;
+    XfdesktopFileEventKind kind;
+    GFileInfo *info;
+    XfdesktopFileEventBatch *batch;
+} XfdesktopFileEvent;
+
+/* how many icons' metadata is fetched at once after the gvfs metadata
+ * changes */
+#define METADATA_BATCH  32
+
+/* how many folders on the desktop get a file monitor for cover art; the
+ * rest are polled */
+#define DEFAULT_MAX_FOLDER_WATCHES  64
+
+typedef struct
+{
+    XfdesktopFileIconManager *fmanager;
+    GCancellable *cancellable;
+    /* GFiles still to be checked */
+    GList *files;
+    gint outstanding;
+} XfdesktopMetadataRefresh;
+
+typedef struct
+{
+    XfdesktopFileIconManager *fmanager;
+    GCancellable *cancellable;
+} XfdesktopLauncherLoad;
+
 typedef enum
 {
     PROP0 = 0,
@@ -92,6 +159,7 @@ typedef enum
     PROP_SHOW_UNKNOWN_VOLUME,
     PROP_SHOW_THUMBNAILS,
     PROP_MAX_TEMPLATES,
+    PROP_MAX_FOLDER_WATCHES,
 } XfdesktopFileIconManagerProp;
 
 struct _XfdesktopFileIconManagerPrivate
@@ -108,12 +176,29 @@ struct _XfdesktopFileIconManagerPrivate
     GFile *folder;
     XfdesktopFileIcon *desktop_icon;
     GFileMonitor *monitor;
+    /* GFile -> XfdesktopFileEventKind, for events that haven't been
+     * handled yet */
+    GHashTable *pending_events;
+    guint pending_events_id;
+    /* XfdesktopFileEventBatch, oldest first; each one is applied once its
+     * file info is in and everything before it has been applied */
+    GQueue event_batches;
+    GCancellable *events_cancellable;
+    guint events_received;
+    guint events_coalesced;
+    guint events_applied;
     GFileEnumerator *enumerator;
+    gint enumerator_batch;
+    gint64 enumerator_requested;
+    gint64 load_start;
 
     GVolumeMonitor *volume_monitor;
 
     GFileMonitor *metadata_monitor;
     guint metadata_timer;
+    XfdesktopMetadataRefresh *metadata_refresh;
+    guint metadata_queried;
+    guint metadata_changed;
 
     GHashTable *icons;
     GHashTable *removable_icons;
@@ -127,9 +212,18 @@ struct _XfdesktopFileIconManagerPrivate
     gboolean show_thumbnails;
     
     guint save_icons_id;
+
+    /* saved icon positions, one section per resolution */
+    XfdesktopPositionStore *position_store;
     
     GQueue *pending_icons;
+    /* XfdesktopFileIcon -> its link in pending_icons */
+    GHashTable *pending_icons_index;
     guint pending_icons_id;
+    /* when the queue last went from empty to non-empty, and how many icons
+     * have been added to the icon view since */
+    gint64 pending_icons_start;
+    guint pending_icons_added;
     
     GtkTargetList *drag_targets;
     GtkTargetList *drop_targets;
@@ -141,6 +235,10 @@ struct _XfdesktopFileIconManagerPrivate
 
     XfdesktopThumbnailer *thumbnailer;
 
+    /* cover art monitoring for all folder icons */
+    XfdesktopFolderWatcher *folder_watcher;
+    guint max_folder_watches;
+
     guint max_templates;
 };
 
@@ -332,6 +430,13 @@ xfdesktop_file_icon_manager_class_init(XfdesktopFileIconManagerClass *klass)
                                                       "max-templates",
                                                       0, G_MAXUSHORT, 16,
                                                       XFDESKTOP_PARAM_FLAGS));
+    g_object_class_install_property(gobject_class, PROP_MAX_FOLDER_WATCHES,
+                                    g_param_spec_uint("max-folder-watches",
+                                                      "max-folder-watches",
+                                                      "max-folder-watches",
+                                                      1, G_MAXUSHORT,
+                                                      DEFAULT_MAX_FOLDER_WATCHES,
+                                                      XFDESKTOP_PARAM_FLAGS));
 #undef XFDESKTOP_PARAM_FLAGS
 
     xfdesktop_app_info_quark = g_quark_from_static_string("xfdesktop-app-info-quark");
@@ -354,6 +459,8 @@ xfdesktop_file_icon_manager_init(XfdesktopFileIconManager *fmanager)
     fmanager->priv->thumbnailer = xfdesktop_thumbnailer_new();
 
     g_signal_connect(G_OBJECT(fmanager->priv->thumbnailer), "thumbnail-ready", G_CALLBACK(xfdesktop_file_icon_manager_update_image), fmanager);
+
+    fmanager->priv->folder_watcher = xfdesktop_folder_watcher_new(DEFAULT_MAX_FOLDER_WATCHES);
 }
 
 static void
@@ -407,6 +514,12 @@ xfdesktop_file_icon_manager_set_property(GObject *object,
                                                           g_value_get_uint(value));
             break;
 
+        case PROP_MAX_FOLDER_WATCHES:
+            fmanager->priv->max_folder_watches = g_value_get_uint(value);
+            xfdesktop_folder_watcher_set_max_monitors(fmanager->priv->folder_watcher,
+                                                      fmanager->priv->max_folder_watches);
+            break;
+
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
     }
@@ -464,6 +577,10 @@ xfdesktop_file_icon_manager_get_property(GObject *object,
             g_value_set_int(value, fmanager->priv->max_templates);
             break;
 
+        case PROP_MAX_FOLDER_WATCHES:
+            g_value_set_uint(value, fmanager->priv->max_folder_watches);
+            break;
+
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
     }
@@ -485,6 +602,8 @@ xfdesktop_file_icon_manager_finalize(GObject *obj)
     g_object_unref(fmanager->priv->folder);
     g_object_unref(fmanager->priv->thumbnailer);
 
+    xfdesktop_folder_watcher_free(fmanager->priv->folder_watcher);
+
     if(fmanager->priv->volume_monitor != NULL)
         g_object_unref(fmanager->priv->volume_monitor);
 
@@ -1717,39 +1836,34 @@ xfdesktop_file_icon_manager_populate_context_menu(XfceDesktop *desktop,
 }
 
 static void
-file_icon_hash_write_icons(gpointer key,
-                           gpointer value,
-                           gpointer data)
+xfdesktop_file_icon_manager_positions_relpath(XfdesktopFileIconManager *fmanager,
+                                              gchar *relpath,
+                                              gsize len)
 {
-    XfceRc *rcfile = data;
-    XfdesktopIcon *icon = value;
-    guint16 row, col;
-    gchar *identifier = xfdesktop_icon_get_identifier(icon);
-
-    if(xfdesktop_icon_get_position(icon, &row, &col)) {
-        /* Attempt to use the identifier, fall back to using the labels. */
-        if(identifier)
-            xfce_rc_set_group(rcfile, identifier);
-        else
-            xfce_rc_set_group(rcfile, xfdesktop_icon_peek_label(icon));
+    gint x = 0, y = 0, width = 0, height = 0;
 
-        xfce_rc_write_int_entry(rcfile, "row", row);
-        xfce_rc_write_int_entry(rcfile, "col", col);
-    }
+    xfdesktop_get_workarea_single(fmanager->priv->icon_view,
+                                  0,
+                                  &x,
+                                  &y,
+                                  &width,
+                                  &height);
 
-    if(identifier)
-        g_free(identifier);
+    g_snprintf(relpath, len, "xfce4/desktop/icons.screen%d-%dx%d.rc",
+               gdk_screen_get_number(fmanager->priv->gscreen),
+               width,
+               height);
 }
 
-static gboolean
-xfdesktop_file_icon_manager_save_icons(gpointer user_data)
+/* returns the position store, switched to the section for the current
+ * resolution */
+static XfdesktopPositionStore *
+xfdesktop_file_icon_manager_get_position_store(XfdesktopFileIconManager *fmanager)
 {
-    XfdesktopFileIconManager *fmanager = XFDESKTOP_FILE_ICON_MANAGER(user_data);
-    gchar relpath[PATH_MAX], *tmppath, *path;
-    XfceRc *rcfile;
     gint x = 0, y = 0, width = 0, height = 0;
-    
-    fmanager->priv->save_icons_id = 0;
+
+    if(!fmanager->priv->position_store)
+        return NULL;
 
     xfdesktop_get_workarea_single(fmanager->priv->icon_view,
                                   0,
@@ -1758,56 +1872,64 @@ xfdesktop_file_icon_manager_save_icons(gpointer user_data)
                                   &width,
                                   &height);
 
-    g_snprintf(relpath, PATH_MAX, "xfce4/desktop/icons.screen%d-%dx%d.rc",
-               gdk_screen_get_number(fmanager->priv->gscreen),
-               width,
-               height);
+    xfdesktop_position_store_set_section(fmanager->priv->position_store,
+                                         width, height);
 
-    path = xfce_resource_save_location(XFCE_RESOURCE_CONFIG, relpath, TRUE);
-    if(!path)
-        return FALSE;
+    return fmanager->priv->position_store;
+}
+
+static void
+xfdesktop_file_icon_manager_store_position(XfdesktopPositionStore *store,
+                                           XfdesktopIcon *icon)
+{
+    guint16 row, col;
+    gchar *identifier;
 
-    DBG("saving to: %s", path);
+    if(!xfdesktop_icon_get_position(icon, &row, &col))
+        return;
 
-    tmppath = g_strconcat(path, ".new", NULL);
-    
-    rcfile = xfce_rc_simple_open(tmppath, FALSE);
-    if(!rcfile) {
-        g_warning("Unable to determine location of icon position cache file.  " \
-                  "Icon positions will not be saved.");
-        g_free(path);
-        g_free(tmppath);
-        return FALSE;
-    }
+    /* Attempt to use the identifier, fall back to using the labels. */
+    identifier = xfdesktop_icon_get_identifier(icon);
+    if(identifier)
+        xfdesktop_position_store_set(store, identifier, row, col);
+    else if(xfdesktop_icon_peek_label(icon))
+        xfdesktop_position_store_set(store, xfdesktop_icon_peek_label(icon),
+                                     row, col);
+    g_free(identifier);
+}
+
+static void
+file_icon_hash_write_icons(gpointer key,
+                           gpointer value,
+                           gpointer data)
+{
+    xfdesktop_file_icon_manager_store_position(data, XFDESKTOP_ICON(value));
+}
+
+static gboolean
+xfdesktop_file_icon_manager_save_icons(gpointer user_data)
+{
+    XfdesktopFileIconManager *fmanager = XFDESKTOP_FILE_ICON_MANAGER(user_data);
+    XfdesktopPositionStore *store;
+
+    fmanager->priv->save_icons_id = 0;
 
-    xfce_rc_set_group(rcfile, XFDESKTOP_RC_VERSION_STAMP);
-    xfce_rc_write_bool_entry(rcfile, "4.10.3+", TRUE);
+    store = xfdesktop_file_icon_manager_get_position_store(fmanager);
+    if(!store)
+        return FALSE;
 
+    /* only positions that actually changed end up in the journal */
     g_hash_table_foreach(fmanager->priv->icons,
-                         file_icon_hash_write_icons, rcfile);
+                         file_icon_hash_write_icons, store);
     if(fmanager->priv->show_removable_media) {
         g_hash_table_foreach(fmanager->priv->removable_icons,
-                             file_icon_hash_write_icons, rcfile);
+                             file_icon_hash_write_icons, store);
     }
     g_hash_table_foreach(fmanager->priv->special_icons,
-                         file_icon_hash_write_icons, rcfile);
-    
-    xfce_rc_flush(rcfile);
-    xfce_rc_close(rcfile);
+                         file_icon_hash_write_icons, store);
+
+    xfdesktop_position_store_flush(store);
 
-    if(g_file_test(tmppath, G_FILE_TEST_EXISTS)) {
-        if(rename(tmppath, path)) {
-            g_warning("Unable to rename temp file to %s: %s", path,
-                      strerror(errno));
-            unlink(tmppath);
-        }
-    } else {
-        DBG("didn't write anything in the RC file, desktop is probably empty");
-    }
-    
-    g_free(path);
-    g_free(tmppath);
-    
     return FALSE;
 }
 
@@ -1816,6 +1938,13 @@ xfdesktop_file_icon_position_changed(XfdesktopFileIcon *icon,
                                      gpointer user_data)
 {
     XfdesktopFileIconManager *fmanager = XFDESKTOP_FILE_ICON_MANAGER(user_data);
+
+    /* keep the in-memory positions current until the next save */
+    if(icon) {
+        XfdesktopPositionStore *store = xfdesktop_file_icon_manager_get_position_store(fmanager);
+        if(store)
+            xfdesktop_file_icon_manager_store_position(store, XFDESKTOP_ICON(icon));
+    }
     
     if(fmanager->priv->save_icons_id)
         g_source_remove(fmanager->priv->save_icons_id);
@@ -1826,6 +1955,31 @@ xfdesktop_file_icon_position_changed(XfdesktopFileIcon *icon,
 }
 
 
+/* a file that's gone shouldn't leave its position behind for the next file
+ * that turns up with the same name */
+static void
+xfdesktop_file_icon_manager_forget_position(XfdesktopFileIconManager *fmanager,
+                                            XfdesktopFileIcon *icon)
+{
+    XfdesktopPositionStore *store;
+    gchar *identifier;
+
+    store = xfdesktop_file_icon_manager_get_position_store(fmanager);
+    if(!store)
+        return;
+
+    identifier = xfdesktop_icon_get_identifier(XFDESKTOP_ICON(icon));
+    if(identifier)
+        xfdesktop_position_store_remove(store, identifier);
+    if(xfdesktop_icon_peek_label(XFDESKTOP_ICON(icon)))
+        xfdesktop_position_store_remove(store, xfdesktop_icon_peek_label(XFDESKTOP_ICON(icon)));
+    g_free(identifier);
+
+    /* written out with the next save */
+    xfdesktop_file_icon_position_changed(NULL, fmanager);
+}
+
+
 /*   *****   */
 
 void
@@ -1841,59 +1995,49 @@ xfdesktop_file_icon_manager_get_cached_icon_position(XfdesktopFileIconManager *f
                                                      gint16 *row,
                                                      gint16 *col)
 {
-    gchar relpath[PATH_MAX];
-    gchar *filename = NULL;
-    gboolean ret = FALSE;
-    gint x = 0, y = 0, width = 0, height = 0;
+    XfdesktopPositionStore *store;
 
     if(!fmanager || !fmanager->priv)
         return FALSE;
 
-    xfdesktop_get_workarea_single(fmanager->priv->icon_view,
-                                  0,
-                                  &x,
-                                  &y,
-                                  &width,
-                                  &height);
-    
-    g_snprintf(relpath, PATH_MAX, "xfce4/desktop/icons.screen%d-%dx%d.rc",
-               gdk_screen_get_number(fmanager->priv->gscreen),
-               width,
-               height);
-
-    filename = xfce_resource_lookup(XFCE_RESOURCE_CONFIG, relpath);
+    store = xfdesktop_file_icon_manager_get_position_store(fmanager);
+    if(!store)
+        return FALSE;
 
-    /* Check if we have to migrate from the old file format */
-    if(filename == NULL) {
-        g_snprintf(relpath, PATH_MAX, "xfce4/desktop/icons.screen%d.rc",
-        gdk_screen_get_number(fmanager->priv->gscreen));
-        filename = xfce_resource_lookup(XFCE_RESOURCE_CONFIG, relpath);
+    /* Newer versions use the identifier rather than the icon label when
+     * possible; positions imported from old files are keyed by label */
+    if(identifier
+       && xfdesktop_position_store_lookup(store, identifier, row, col))
+    {
+        return TRUE;
     }
 
-    if(filename != NULL) {
-        XfceRc *rcfile;
-        const gchar *icon_name;
-        rcfile = xfce_rc_simple_open(filename, TRUE);
+    return xfdesktop_position_store_lookup(store, name, row, col);
+}
 
-        /* Newer versions use the identifier rather than the icon label when
-         * possible */
-        if(xfce_rc_has_group(rcfile, XFDESKTOP_RC_VERSION_STAMP) && identifier)
-            icon_name = identifier;
-        else
-            icon_name = name;
-
-        if(xfce_rc_has_group(rcfile, icon_name)) {
-            xfce_rc_set_group(rcfile, icon_name);
-            *row = xfce_rc_read_int_entry(rcfile, "row", -1);
-            *col = xfce_rc_read_int_entry(rcfile, "col", -1);
-            if(*row >= 0 && *col >= 0)
-                ret = TRUE;
-        }
-        xfce_rc_close(rcfile);
-        g_free(filename);
-    }
-    
-    return ret;
+/* all folder icons share one watch per folder through the manager */
+void
+xfdesktop_file_icon_manager_watch_folder(XfdesktopFileIconManager *fmanager,
+                                         GFile *folder,
+                                         XfdesktopFolderWatchFunc func,
+                                         gpointer user_data)
+{
+    g_return_if_fail(XFDESKTOP_IS_FILE_ICON_MANAGER(fmanager));
+
+    xfdesktop_folder_watcher_add(fmanager->priv->folder_watcher,
+                                 folder, func, user_data);
+}
+
+void
+xfdesktop_file_icon_manager_unwatch_folder(XfdesktopFileIconManager *fmanager,
+                                           GFile *folder,
+                                           XfdesktopFolderWatchFunc func,
+                                           gpointer user_data)
+{
+    g_return_if_fail(XFDESKTOP_IS_FILE_ICON_MANAGER(fmanager));
+
+    xfdesktop_folder_watcher_remove(fmanager->priv->folder_watcher,
+                                    folder, func, user_data);
 }
 
 
@@ -1933,44 +2077,137 @@ xfdesktop_file_icon_manager_queue_thumbnail(XfdesktopFileIconManager *fmanager,
     }
 }
 
-/* Adds a single icon to the icon view, popping from the top of the stack.
- * Will continue to run until it runs out of icons to add at which point
- * it will free the queue and return FALSE */
+static void
+xfdesktop_file_icon_manager_push_pending_icon(XfdesktopFileIconManager *fmanager,
+                                              XfdesktopFileIcon *icon,
+                                              gboolean to_head)
+{
+    GQueue *queue = fmanager->priv->pending_icons;
+
+    if(to_head)
+        g_queue_push_head(queue, icon);
+    else
+        g_queue_push_tail(queue, icon);
+
+    g_hash_table_insert(fmanager->priv->pending_icons_index, icon,
+                        to_head ? queue->head : queue->tail);
+}
+
+static gboolean
+xfdesktop_file_icon_manager_is_pending_icon(XfdesktopFileIconManager *fmanager,
+                                            XfdesktopFileIcon *icon)
+{
+    return fmanager->priv->pending_icons_index
+           && g_hash_table_lookup(fmanager->priv->pending_icons_index, icon);
+}
+
+/* takes @icon out of the pending queue; returns FALSE if it wasn't there */
+static gboolean
+xfdesktop_file_icon_manager_remove_pending_icon(XfdesktopFileIconManager *fmanager,
+                                                XfdesktopFileIcon *icon)
+{
+    GList *link;
+
+    if(!fmanager->priv->pending_icons_index)
+        return FALSE;
+
+    link = g_hash_table_lookup(fmanager->priv->pending_icons_index, icon);
+    if(!link)
+        return FALSE;
+
+    g_queue_delete_link(fmanager->priv->pending_icons, link);
+    g_hash_table_remove(fmanager->priv->pending_icons_index, icon);
+
+    return TRUE;
+}
+
+static void
+xfdesktop_file_icon_manager_free_pending_icons(XfdesktopFileIconManager *fmanager)
+{
+    if(fmanager->priv->pending_icons) {
+        g_queue_free(fmanager->priv->pending_icons);
+        fmanager->priv->pending_icons = NULL;
+    }
+
+    if(fmanager->priv->pending_icons_index) {
+        g_hash_table_destroy(fmanager->priv->pending_icons_index);
+        fmanager->priv->pending_icons_index = NULL;
+    }
+}
+
+/* Adds icons to the icon view, popping from the top of the stack, for as
+ * long as PENDING_ICONS_BUDGET allows, and paints them all at once.  Will
+ * continue to run until it runs out of icons to add at which point it will
+ * free the queue and return FALSE */
 static gboolean
 process_icon_from_queue(gpointer user_data)
 {
     XfdesktopFileIconManager *fmanager;
     XfdesktopFileIcon *icon;
+    gint64 deadline;
 
     g_return_val_if_fail(XFDESKTOP_IS_FILE_ICON_MANAGER(user_data), FALSE);
 
     fmanager = XFDESKTOP_FILE_ICON_MANAGER(user_data);
 
-    /* Free our queue and return FALSE when we run out of items */
-    if(g_queue_is_empty(fmanager->priv->pending_icons)) {
-        g_queue_free(fmanager->priv->pending_icons);
-        fmanager->priv->pending_icons = NULL;
-        fmanager->priv->pending_icons_id = 0;
-        return FALSE;
-    }
+    deadline = g_get_monotonic_time() + PENDING_ICONS_BUDGET;
 
-    icon = g_queue_pop_head(fmanager->priv->pending_icons);
+    xfdesktop_icon_view_begin_batch(fmanager->priv->icon_view);
 
-    /* skip bad icons */
-    if(icon == NULL || !XFDESKTOP_IS_FILE_ICON(icon))
-        return TRUE;
+    do {
+        GList *chunk = NULL;
+        gint n;
 
-    /* Pay attention to position changes and add the icon to the icon view */
-    g_signal_connect(G_OBJECT(icon), "position-changed",
-                     G_CALLBACK(xfdesktop_file_icon_position_changed),
-                     fmanager);
-    xfdesktop_icon_view_add_item(fmanager->priv->icon_view,
-                                 XFDESKTOP_ICON(icon));
+        for(n = 0;
+            n < PENDING_ICONS_CHUNK && !g_queue_is_empty(fmanager->priv->pending_icons);
+            ++n)
+        {
+            icon = g_queue_pop_head(fmanager->priv->pending_icons);
+            g_hash_table_remove(fmanager->priv->pending_icons_index, icon);
+
+            /* skip bad icons */
+            if(icon == NULL || !XFDESKTOP_IS_FILE_ICON(icon))
+                continue;
+
+            /* Pay attention to position changes and add the icon to the icon view */
+            g_signal_connect(G_OBJECT(icon), "position-changed",
+                             G_CALLBACK(xfdesktop_file_icon_position_changed),
+                             fmanager);
+            chunk = g_list_prepend(chunk, icon);
 
 #if defined(DEBUG) && DEBUG > 0
-    _alive_icon_list = g_list_prepend(_alive_icon_list, icon);
-    g_object_weak_ref(G_OBJECT(icon), _icon_notify_destroy, NULL);
+            _alive_icon_list = g_list_prepend(_alive_icon_list, icon);
+            g_object_weak_ref(G_OBJECT(icon), _icon_notify_destroy, NULL);
 #endif
+        }
+
+        chunk = g_list_reverse(chunk);
+        xfdesktop_icon_view_add_items(fmanager->priv->icon_view, chunk);
+
+        if(chunk && fmanager->priv->pending_icons_added == 0
+           && fmanager->priv->load_start)
+        {
+            DBG("time to first icon: %.1f ms",
+                (g_get_monotonic_time() - fmanager->priv->load_start) / 1000.0);
+            fmanager->priv->load_start = 0;
+        }
+        fmanager->priv->pending_icons_added += g_list_length(chunk);
+        g_list_free(chunk);
+    } while(!g_queue_is_empty(fmanager->priv->pending_icons)
+            && g_get_monotonic_time() < deadline);
+
+    xfdesktop_icon_view_end_batch(fmanager->priv->icon_view);
+
+    /* Free our queue and return FALSE when we run out of items */
+    if(g_queue_is_empty(fmanager->priv->pending_icons)) {
+        DBG("time to last icon: %.1f ms for %u icons",
+            (g_get_monotonic_time() - fmanager->priv->pending_icons_start) / 1000.0,
+            fmanager->priv->pending_icons_added);
+
+        xfdesktop_file_icon_manager_free_pending_icons(fmanager);
+        fmanager->priv->pending_icons_id = 0;
+        return FALSE;
+    }
 
     return TRUE;
 }
@@ -1990,8 +2227,13 @@ xfdesktop_file_icon_manager_add_icon(XfdesktopFileIconManager *fmanager,
     identifier = xfdesktop_icon_get_identifier(XFDESKTOP_ICON(icon));
 
     /* Create our pending icon queue */
-    if(fmanager->priv->pending_icons == NULL)
+    if(fmanager->priv->pending_icons == NULL) {
         fmanager->priv->pending_icons = g_queue_new();
+        fmanager->priv->pending_icons_index = g_hash_table_new(g_direct_hash,
+                                                               g_direct_equal);
+        fmanager->priv->pending_icons_start = g_get_monotonic_time();
+        fmanager->priv->pending_icons_added = 0;
+    }
 
     /* See if our icon had a spot on in the icon view, if it did then it goes
      * to the front of the pending icon queue, if it didn't then we place it
@@ -1999,27 +2241,26 @@ xfdesktop_file_icon_manager_add_icon(XfdesktopFileIconManager *fmanager,
     if(row >= 0 && col >= 0) {
         DBG("attempting to set icon '%s' to position (%d,%d)", name, row, col);
         xfdesktop_icon_set_position(XFDESKTOP_ICON(icon), row, col);
-        g_queue_push_head(fmanager->priv->pending_icons, icon);
+        xfdesktop_file_icon_manager_push_pending_icon(fmanager, icon, TRUE);
     } else if(xfdesktop_file_icon_manager_get_cached_icon_position(fmanager,
                                                                    name, identifier,
                                                                    &row, &col))
     {
         DBG("attempting to set icon '%s' to position (%d,%d)", name, row, col);
         xfdesktop_icon_set_position(XFDESKTOP_ICON(icon), row, col);
-        g_queue_push_head(fmanager->priv->pending_icons, icon);
+        xfdesktop_file_icon_manager_push_pending_icon(fmanager, icon, TRUE);
     } else {
         /* Didn't have a spot, push it to the end of the stack */
-        g_queue_push_tail(fmanager->priv->pending_icons, icon);
+        xfdesktop_file_icon_manager_push_pending_icon(fmanager, icon, FALSE);
     }
 
-    if(fmanager->priv->pending_icons_id != 0)
-        g_source_remove(fmanager->priv->pending_icons_id);
-
     /* While xfdesktop is idle we'll add icons to the icon view */
-    fmanager->priv->pending_icons_id = g_idle_add_full(G_PRIORITY_LOW,
-                                                       process_icon_from_queue,
-                                                       fmanager,
-                                                       NULL);
+    if(fmanager->priv->pending_icons_id == 0) {
+        fmanager->priv->pending_icons_id = g_idle_add_full(G_PRIORITY_LOW,
+                                                           process_icon_from_queue,
+                                                           fmanager,
+                                                           NULL);
+    }
 
     if(identifier)
         g_free(identifier);
@@ -2030,27 +2271,19 @@ static void
 xfdesktop_file_icon_manager_remove_icon(XfdesktopFileIconManager *fmanager,
                                         XfdesktopFileIcon *icon)
 {
-    GList *item = NULL;
-
     g_return_if_fail(XFDESKTOP_IS_FILE_ICON_MANAGER(fmanager));
     g_return_if_fail(XFDESKTOP_IS_FILE_ICON(icon));
 
     /* find out if the icon was pending creation */
-    if(fmanager->priv->pending_icons)
-        item = g_queue_find(fmanager->priv->pending_icons, icon);
-
-    if(item && item->data && XFDESKTOP_IS_FILE_ICON(item->data)) {
-        gchar *filename = g_file_get_path(xfdesktop_file_icon_peek_file(item->data));
+    if(xfdesktop_file_icon_manager_remove_pending_icon(fmanager, icon)) {
+        gchar *filename = g_file_get_path(xfdesktop_file_icon_peek_file(icon));
 
         DBG("removing %s from pending queue", filename);
 
-        /* Icon was pending creation, dequeue the thumbnail and
-         * remove it from the pending icons queue */
+        /* Icon was pending creation, dequeue the thumbnail */
         xfdesktop_thumbnailer_dequeue_thumbnail(fmanager->priv->thumbnailer,
                                                 filename);
 
-        g_queue_remove(fmanager->priv->pending_icons, icon);
-
         g_free(filename);
     } else {
         DBG("removing icon %s from icon view", xfdesktop_icon_peek_label(XFDESKTOP_ICON(icon)));
@@ -2064,13 +2297,15 @@ xfdesktop_file_icon_manager_remove_icon(XfdesktopFileIconManager *fmanager,
 }
 
 /* If row and col are set then they will be used, otherwise set them to -1
- * and it will lookup the position in the rc file */
+ * and it will lookup the position in the rc file.  check_entry is FALSE if
+ * the caller has already read the .desktop file and decided to show it */
 static XfdesktopFileIcon *
 xfdesktop_file_icon_manager_add_regular_icon(XfdesktopFileIconManager *fmanager,
                                              GFile *file,
                                              GFileInfo *info,
                                              guint16 row, guint16 col,
-                                             gboolean defer_if_missing)
+                                             gboolean defer_if_missing,
+                                             gboolean check_entry)
 {
     XfdesktopRegularFileIcon *icon = NULL;
     gboolean is_desktop_file = FALSE;
@@ -2093,35 +2328,10 @@ xfdesktop_file_icon_manager_add_regular_icon(XfdesktopFileIconManager *fmanager,
     /* if it's a .desktop file, and it has Hidden=true, or an
      * OnlyShowIn Or NotShowIn that would hide it from Xfce, don't
      * show it on the desktop (bug #4022) */
-    if(is_desktop_file)
+    if(is_desktop_file && check_entry
+       && !xfdesktop_desktop_entry_should_show(xfdesktop_desktop_entry_lookup(file, info)))
     {
-        gchar *path = g_file_get_path(file);
-        XfceRc *rcfile = xfce_rc_simple_open(path, TRUE);
-        g_free(path);
-
-        if(rcfile) {
-            const gchar *value;
-
-            xfce_rc_set_group(rcfile, "Desktop Entry");
-            if(xfce_rc_read_bool_entry(rcfile, "Hidden", FALSE)) {
-                xfce_rc_close(rcfile);
-                return NULL;
-            }
-
-            value = xfce_rc_read_entry(rcfile, "OnlyShowIn", NULL);
-            if(value && strncmp(value, "XFCE;", 5) && !strstr(value, ";XFCE;")) {
-                xfce_rc_close(rcfile);
-                return NULL;
-            }
-
-            value = xfce_rc_read_entry(rcfile, "NotShowIn", NULL);
-            if(value && (!strncmp(value, "XFCE;", 5) || strstr(value, ";XFCE;"))) {
-                xfce_rc_close(rcfile);
-                return NULL;
-            }
-
-            xfce_rc_close(rcfile);
-        }
+        return NULL;
     }
 
     /* If it's a hidden or backup file don't show it on the desktop */
@@ -2130,6 +2340,14 @@ xfdesktop_file_icon_manager_add_regular_icon(XfdesktopFileIconManager *fmanager,
 
     /* should never return NULL */
     icon = xfdesktop_regular_file_icon_new(file, info, fmanager->priv->gscreen, fmanager);
+
+    /* cut-changed only covers icons that already exist */
+    if(G_UNLIKELY(clipboard_manager
+                  && xfdesktop_clipboard_manager_has_cutted_file(clipboard_manager,
+                                                                 XFDESKTOP_FILE_ICON(icon))))
+    {
+        xfdesktop_regular_file_icon_set_pixbuf_opacity(icon, 50);
+    }
     
     xfdesktop_file_icon_manager_add_icon(fmanager,
                                          XFDESKTOP_FILE_ICON(icon),
@@ -2209,15 +2427,10 @@ xfdesktop_remove_icons_ht(gpointer key,
                           gpointer user_data)
 {
     XfdesktopFileIconManager *fmanager = XFDESKTOP_FILE_ICON_MANAGER(user_data);
-    XfdesktopIcon *icon = XFDESKTOP_ICON(value);
-    GList *item = NULL;
-
-    /* find out if the icon was pending creation */
-    if(fmanager->priv->pending_icons)
-        item = g_queue_find(fmanager->priv->pending_icons, icon);
+    XfdesktopFileIcon *icon = XFDESKTOP_FILE_ICON(value);
 
     /* Remove the icon if it was in the icon view */
-    if(item == NULL) {
+    if(!xfdesktop_file_icon_manager_is_pending_icon(fmanager, icon)) {
         xfdesktop_icon_view_remove_item(fmanager->priv->icon_view,
                                         XFDESKTOP_ICON(value));
     }
@@ -2370,104 +2583,398 @@ xfdesktop_file_icon_manager_key_press(GtkWidget *widget,
 }
 
 static void
-xfdesktop_file_icon_manager_file_changed(GFileMonitor     *monitor,
-                                         GFile            *file,
-                                         GFile            *other_file,
-                                         GFileMonitorEvent event,
-                                         gpointer          user_data)
+xfdesktop_file_icon_manager_file_deleted(XfdesktopFileIconManager *fmanager,
+                                         GFile *file)
 {
-    XfdesktopFileIconManager *fmanager = XFDESKTOP_FILE_ICON_MANAGER(user_data);
-    XfdesktopFileIcon *icon, *moved_icon;
-    GFileInfo *file_info;
-    guint16 row = 0, col = 0;
+    XfdesktopFileIcon *icon;
     gchar *filename;
 
-    switch(event) {
-        case G_FILE_MONITOR_EVENT_MOVED:
-            DBG("got a moved event");
+    filename = g_file_get_path(file);
 
-            icon = g_hash_table_lookup(fmanager->priv->icons, file);
+    icon = g_hash_table_lookup(fmanager->priv->icons, file);
+    if(icon) {
+        xfdesktop_file_icon_manager_forget_position(fmanager, icon);
 
-            file_info = g_file_query_info(other_file, XFDESKTOP_FILE_INFO_NAMESPACE,
-                                          G_FILE_QUERY_INFO_NONE, NULL, NULL);
+        /* find out if the icon was pending creation */
+        if(xfdesktop_file_icon_manager_remove_pending_icon(fmanager, icon)) {
+            /* Icon was pending creation, dequeue the thumbnail */
+            xfdesktop_thumbnailer_dequeue_thumbnail(fmanager->priv->thumbnailer,
+                                                    filename);
+        } else {
+            /* Always try to remove thumbnail so it doesn't take up
+             * space on the user's disk. */
+            xfdesktop_thumbnailer_delete_thumbnail(fmanager->priv->thumbnailer,
+                                                   filename);
+
+            /* Remove icon from the icon view */
+            xfdesktop_icon_view_remove_item(fmanager->priv->icon_view,
+                                            XFDESKTOP_ICON(icon));
+        }
 
-            if(icon) {
-                /* Get the old position so we can use it for the new icon */
-                if(!xfdesktop_icon_get_position(XFDESKTOP_ICON(icon), &row, &col)) {
-                    /* Failed to get position... not supported? */
-                    row = col = 0;
-                }
-                DBG("row %d, col %d", row, col);
+        /* always remove from the hash table */
+        g_hash_table_remove(fmanager->priv->icons, file);
+    } else {
+        if(g_file_equal(file, fmanager->priv->folder)) {
+            DBG("~/Desktop disappeared!");
+            /* yes, refresh before and after is correct */
+            xfdesktop_file_icon_manager_refresh_icons(fmanager);
+            xfdesktop_file_icon_manager_check_create_desktop_folder(fmanager->priv->folder);
+            xfdesktop_file_icon_manager_refresh_icons(fmanager);
+        }
+    }
 
-                /* Remove the old icon */
-                xfdesktop_file_icon_manager_remove_icon(fmanager, icon);
-            }
+    if(filename)
+        g_free(filename);
+}
 
-            /* Check to see if there's already an other_file represented on
-             * the desktop and remove it so there aren't duplicated icons
-             * present. */
-            moved_icon = g_hash_table_lookup(fmanager->priv->icons, other_file);
-            if(moved_icon) {
-                /* Since we're replacing an existing icon, get that location
-                 * to use instead */
-                if(!xfdesktop_icon_get_position(XFDESKTOP_ICON(moved_icon), &row, &col)) {
-                    /* Failed to get position... not supported? */
-                    row = col = 0;
-                }
-                DBG("row %d, col %d", row, col);
+static void
+xfdesktop_file_icon_manager_apply_file_moved(XfdesktopFileIconManager *fmanager,
+                                             XfdesktopFileEvent *event)
+{
+    XfdesktopFileIcon *icon, *moved_icon;
+    guint16 row = 0, col = 0;
 
-                xfdesktop_file_icon_manager_remove_icon(fmanager, moved_icon);
-            }
+    icon = g_hash_table_lookup(fmanager->priv->icons, event->file);
+    if(icon) {
+        /* Get the old position so we can use it for the new icon */
+        if(!xfdesktop_icon_get_position(XFDESKTOP_ICON(icon), &row, &col)) {
+            /* Failed to get position... not supported? */
+            row = col = 0;
+        }
+        DBG("row %d, col %d", row, col);
 
-            if(xfdesktop_compare_paths(g_file_get_parent(other_file), fmanager->priv->folder)) {
-                DBG("icon moved off the desktop");
-                /* Nothing moved, this is actually a delete */
-                if(file_info)
-                    g_object_unref(file_info);
+        /* Remove the old icon; the new one saves its own position */
+        xfdesktop_file_icon_manager_forget_position(fmanager, icon);
+        xfdesktop_file_icon_manager_remove_icon(fmanager, icon);
+    }
 
-                return;
-            }
+    /* Check to see if there's already an other_file represented on
+     * the desktop and remove it so there aren't duplicated icons
+     * present. */
+    moved_icon = g_hash_table_lookup(fmanager->priv->icons, event->other_file);
+    if(moved_icon) {
+        /* Since we're replacing an existing icon, get that location
+         * to use instead */
+        if(!xfdesktop_icon_get_position(XFDESKTOP_ICON(moved_icon), &row, &col)) {
+            /* Failed to get position... not supported? */
+            row = col = 0;
+        }
+        DBG("row %d, col %d", row, col);
 
-            if(file_info) {
-                gboolean is_hidden;
+        xfdesktop_file_icon_manager_remove_icon(fmanager, moved_icon);
+    }
 
+    /* no info if it moved off the desktop or is already gone again */
+    if(event->info) {
+        gboolean is_hidden;
+
+        is_hidden = g_file_info_get_attribute_boolean(event->info,
+                                                      G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN);
+        if(!is_hidden) {
+            /* Add the icon adding the row/col info */
+            icon = xfdesktop_file_icon_manager_add_regular_icon(fmanager,
+                                                                event->other_file,
+                                                                event->info,
+                                                                row,
+                                                                col,
+                                                                FALSE,
+                                                                TRUE);
+            if(icon)
+                xfdesktop_file_icon_position_changed(icon, fmanager);
+        }
+    }
+}
 
-                is_hidden = g_file_info_get_attribute_boolean(file_info,
-                                                              G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN);
+static void
+xfdesktop_file_icon_manager_apply_file_event(XfdesktopFileIconManager *fmanager,
+                                             XfdesktopFileEvent *event)
+{
+    XfdesktopFileIcon *icon = g_hash_table_lookup(fmanager->priv->icons,
+                                                  event->file);
+
+    switch(event->kind) {
+        case XFDESKTOP_FILE_EVENT_CREATED:
+            /* first make sure we don't already have an icon for this path.
+             * this seems to be necessary to avoid inconsistencies */
+            if(icon) {
+                /* Remove the old icon */
+                xfdesktop_file_icon_manager_remove_icon(fmanager, icon);
+            }
+
+            if(event->info) {
+                gboolean is_hidden = g_file_info_get_attribute_boolean(event->info,
+                                                                       G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN);
                 if(!is_hidden) {
-                    /* Add the icon adding the row/col info */
-                    icon = xfdesktop_file_icon_manager_add_regular_icon(fmanager,
-                                                                        other_file,
-                                                                        file_info,
-                                                                        row,
-                                                                        col,
-                                                                        FALSE);
-                    if(icon)
-                        xfdesktop_file_icon_position_changed(icon, fmanager);
+                    xfdesktop_file_icon_manager_add_regular_icon(fmanager,
+                                                                 event->file,
+                                                                 event->info,
+                                                                 -1, -1,
+                                                                 TRUE, TRUE);
                 }
-
-                g_object_unref(file_info);
             }
             break;
-        case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
-        case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
-            DBG("got changed event");
-
-            icon = g_hash_table_lookup(fmanager->priv->icons, file);
+        case XFDESKTOP_FILE_EVENT_CHANGED:
             if(icon) {
-                file_info = g_file_query_info(file, XFDESKTOP_FILE_INFO_NAMESPACE,
-                                              G_FILE_QUERY_INFO_NONE, NULL, NULL);
-
-                if(file_info) {
+                if(event->info) {
                     /* update the icon if the file still exists */
-                    xfdesktop_file_icon_update_file_info(icon, file_info);
-                    g_object_unref(file_info);
+                    xfdesktop_file_icon_update_file_info(icon, event->info);
                 } else {
                     /* Remove the icon as it doesn't seem to exist */
+                    xfdesktop_file_icon_manager_forget_position(fmanager, icon);
                     xfdesktop_file_icon_manager_remove_icon(fmanager, icon);
                 }
             }
             break;
+        case XFDESKTOP_FILE_EVENT_DELETED:
+            xfdesktop_file_icon_manager_file_deleted(fmanager, event->file);
+            break;
+        case XFDESKTOP_FILE_EVENT_MOVED:
+            xfdesktop_file_icon_manager_apply_file_moved(fmanager, event);
+            break;
+    }
+
+    fmanager->priv->events_applied++;
+}
+
+static void
+xfdesktop_file_icon_manager_file_event_free(XfdesktopFileEvent *event)
+{
+    g_object_unref(event->file);
+    if(event->other_file)
+        g_object_unref(event->other_file);
+    if(event->info)
+        g_object_unref(event->info);
+    g_slice_free(XfdesktopFileEvent, event);
+}
+
+static void
+xfdesktop_file_icon_manager_file_event_batch_free(XfdesktopFileEventBatch *batch)
+{
+    g_list_foreach(batch->events, (GFunc)xfdesktop_file_icon_manager_file_event_free, NULL);
+    g_list_free(batch->events);
+    g_object_unref(batch->cancellable);
+    g_slice_free(XfdesktopFileEventBatch, batch);
+}
+
+/* starts a batch behind all the ones still waiting; it's held open until
+ * the caller has queued everything for it */
+static XfdesktopFileEventBatch *
+xfdesktop_file_icon_manager_file_event_batch_new(XfdesktopFileIconManager *fmanager)
+{
+    XfdesktopFileEventBatch *batch = g_slice_new0(XfdesktopFileEventBatch);
+
+    batch->fmanager = fmanager;
+    batch->cancellable = g_object_ref(fmanager->priv->events_cancellable);
+    batch->outstanding = 1;
+
+    g_queue_push_tail(&fmanager->priv->event_batches, batch);
+
+    return batch;
+}
+
+/* applies finished batches in the order they were started, so a slow
+ * query for an older event can't undo a newer one */
+static void
+xfdesktop_file_icon_manager_apply_file_event_batches(XfdesktopFileIconManager *fmanager)
+{
+    XfdesktopFileEventBatch *batch;
+    GList *l;
+
+    while((batch = g_queue_peek_head(&fmanager->priv->event_batches))
+          && batch->outstanding == 0)
+    {
+        g_queue_pop_head(&fmanager->priv->event_batches);
+
+        batch->events = g_list_reverse(batch->events);
+
+        xfdesktop_icon_view_begin_batch(fmanager->priv->icon_view);
+        for(l = batch->events; l; l = l->next)
+            xfdesktop_file_icon_manager_apply_file_event(fmanager, l->data);
+        xfdesktop_icon_view_end_batch(fmanager->priv->icon_view);
+
+        DBG("file events: %u received, %u coalesced, %u applied",
+            fmanager->priv->events_received, fmanager->priv->events_coalesced,
+            fmanager->priv->events_applied);
+
+        xfdesktop_file_icon_manager_file_event_batch_free(batch);
+    }
+}
+
+static void
+xfdesktop_file_icon_manager_file_event_batch_done(XfdesktopFileEventBatch *batch)
+{
+    if(--batch->outstanding > 0)
+        return;
+
+    /* the manager dropped its queue when it cancelled us, and may be gone */
+    if(g_cancellable_is_cancelled(batch->cancellable))
+        xfdesktop_file_icon_manager_file_event_batch_free(batch);
+    else
+        xfdesktop_file_icon_manager_apply_file_event_batches(batch->fmanager);
+}
+
+static void
+xfdesktop_file_icon_manager_file_event_info_ready(GObject *source,
+                                                  GAsyncResult *result,
+                                                  gpointer user_data)
+{
+    XfdesktopFileEvent *event = user_data;
+    XfdesktopFileEventBatch *batch = event->batch;
+
+    /* a missing file just means there's nothing to add or update */
+    event->info = g_file_query_info_finish(G_FILE(source), result, NULL);
+    batch->events = g_list_prepend(batch->events, event);
+
+    xfdesktop_file_icon_manager_file_event_batch_done(batch);
+}
+
+static void
+xfdesktop_file_icon_manager_file_event_query_info(XfdesktopFileEventBatch *batch,
+                                                  XfdesktopFileEvent *event,
+                                                  GFile *file)
+{
+    batch->outstanding++;
+    g_file_query_info_async(file, XFDESKTOP_FILE_INFO_NAMESPACE,
+                            G_FILE_QUERY_INFO_NONE, G_PRIORITY_DEFAULT,
+                            batch->cancellable,
+                            xfdesktop_file_icon_manager_file_event_info_ready,
+                            event);
+}
+
+/* starts fetching file info for everything collected since the last flush;
+ * the whole lot is applied in one go once the last of it has arrived */
+static gboolean
+xfdesktop_file_icon_manager_flush_file_events(gpointer user_data)
+{
+    XfdesktopFileIconManager *fmanager = XFDESKTOP_FILE_ICON_MANAGER(user_data);
+    XfdesktopFileEventBatch *batch;
+    GHashTable *pending = fmanager->priv->pending_events;
+    GHashTableIter iter;
+    gpointer key, value;
+
+    if(fmanager->priv->pending_events_id) {
+        g_source_remove(fmanager->priv->pending_events_id);
+        fmanager->priv->pending_events_id = 0;
+    }
+
+    if(!pending)
+        return FALSE;
+    fmanager->priv->pending_events = NULL;
+
+    batch = xfdesktop_file_icon_manager_file_event_batch_new(fmanager);
+
+    g_hash_table_iter_init(&iter, pending);
+    while(g_hash_table_iter_next(&iter, &key, &value)) {
+        XfdesktopFileEvent *event = g_slice_new0(XfdesktopFileEvent);
+
+        event->file = g_object_ref(key);
+        event->kind = GPOINTER_TO_INT(value);
+        event->batch = batch;
+
+        if(event->kind == XFDESKTOP_FILE_EVENT_DELETED)
+            batch->events = g_list_prepend(batch->events, event);
+        else
+            xfdesktop_file_icon_manager_file_event_query_info(batch, event, event->file);
+    }
+
+    g_hash_table_destroy(pending);
+
+    xfdesktop_file_icon_manager_file_event_batch_done(batch);
+
+    return FALSE;
+}
+
+/* a move gets a batch of its own, after whatever was queued before it */
+static void
+xfdesktop_file_icon_manager_queue_file_moved(XfdesktopFileIconManager *fmanager,
+                                             GFile *file,
+                                             GFile *other_file)
+{
+    XfdesktopFileEventBatch *batch;
+    XfdesktopFileEvent *event;
+    GFile *parent;
+
+    xfdesktop_file_icon_manager_flush_file_events(fmanager);
+
+    fmanager->priv->events_received++;
+
+    batch = xfdesktop_file_icon_manager_file_event_batch_new(fmanager);
+
+    event = g_slice_new0(XfdesktopFileEvent);
+    event->file = g_object_ref(file);
+    event->other_file = g_object_ref(other_file);
+    event->kind = XFDESKTOP_FILE_EVENT_MOVED;
+    event->batch = batch;
+
+    parent = g_file_get_parent(other_file);
+    if(xfdesktop_compare_paths(parent, fmanager->priv->folder)) {
+        DBG("icon moved off the desktop");
+        /* Nothing moved, this is actually a delete */
+        batch->events = g_list_prepend(batch->events, event);
+    } else
+        xfdesktop_file_icon_manager_file_event_query_info(batch, event, other_file);
+    g_object_unref(parent);
+
+    xfdesktop_file_icon_manager_file_event_batch_done(batch);
+}
+
+static void
+xfdesktop_file_icon_manager_queue_file_event(XfdesktopFileIconManager *fmanager,
+                                             GFile *file,
+                                             XfdesktopFileEventKind kind)
+{
+    XfdesktopFileEventKind old_kind;
+
+    if(!fmanager->priv->pending_events) {
+        fmanager->priv->pending_events = g_hash_table_new_full(g_file_hash,
+                                                               (GEqualFunc)g_file_equal,
+                                                               g_object_unref,
+                                                               NULL);
+    }
+
+    fmanager->priv->events_received++;
+
+    old_kind = GPOINTER_TO_INT(g_hash_table_lookup(fmanager->priv->pending_events,
+                                                   file));
+    if(old_kind) {
+        fmanager->priv->events_coalesced++;
+
+        /* a change doesn't add anything to a pending creation or deletion;
+         * otherwise the latest event wins */
+        if(kind == XFDESKTOP_FILE_EVENT_CHANGED)
+            return;
+    }
+
+    g_hash_table_replace(fmanager->priv->pending_events, g_object_ref(file),
+                         GINT_TO_POINTER(kind));
+
+    if(!fmanager->priv->pending_events_id) {
+        fmanager->priv->pending_events_id = g_timeout_add(FILE_EVENT_DELAY,
+                                                          xfdesktop_file_icon_manager_flush_file_events,
+                                                          fmanager);
+    }
+}
+
+static void
+xfdesktop_file_icon_manager_file_changed(GFileMonitor     *monitor,
+                                         GFile            *file,
+                                         GFile            *other_file,
+                                         GFileMonitorEvent event,
+                                         gpointer          user_data)
+{
+    XfdesktopFileIconManager *fmanager = XFDESKTOP_FILE_ICON_MANAGER(user_data);
+
+    switch(event) {
+        case G_FILE_MONITOR_EVENT_MOVED:
+            DBG("got a moved event");
+            xfdesktop_file_icon_manager_queue_file_moved(fmanager, file, other_file);
+            break;
+        case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
+        case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+            DBG("got changed event");
+            xfdesktop_file_icon_manager_queue_file_event(fmanager, file,
+                                                         XFDESKTOP_FILE_EVENT_CHANGED);
+            break;
         case G_FILE_MONITOR_EVENT_CREATED:
             DBG("got created event");
 
@@ -2475,97 +2982,142 @@ xfdesktop_file_icon_manager_file_changed(GFileMonitor     *monitor,
             if(g_file_equal(fmanager->priv->folder, file))
                 return;
 
-            /* first make sure we don't already have an icon for this path.
-             * this seems to be necessary to avoid inconsistencies */
-            icon = g_hash_table_lookup(fmanager->priv->icons, file);
-            if(icon) {
-                /* Remove the old icon */
-                xfdesktop_file_icon_manager_remove_icon(fmanager, icon);
-            }
-            
-            file_info = g_file_query_info(file, XFDESKTOP_FILE_INFO_NAMESPACE,
-                                          G_FILE_QUERY_INFO_NONE, NULL, NULL);
-            if(file_info) {
-                gboolean is_hidden = g_file_info_get_attribute_boolean(file_info,
-                                                                       G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN);
-                if(!is_hidden) {
-                    xfdesktop_file_icon_manager_add_regular_icon(fmanager,
-                                                                 file, file_info,
-                                                                 -1, -1,
-                                                                 TRUE);
-                }
-
-                g_object_unref(file_info);
-            }
+            xfdesktop_file_icon_manager_queue_file_event(fmanager, file,
+                                                         XFDESKTOP_FILE_EVENT_CREATED);
             break;
         case G_FILE_MONITOR_EVENT_DELETED:
             DBG("got deleted event");
+            xfdesktop_file_icon_manager_queue_file_event(fmanager, file,
+                                                         XFDESKTOP_FILE_EVENT_DELETED);
+            break;
+        default:
+            break;
+    }
+}
 
-            filename = g_file_get_path(file);
+/* all metadata:: attributes of @info, as a string that is equal for two
+ * infos exactly when their metadata is */
+static gchar *
+xfdesktop_file_icon_manager_metadata_string(GFileInfo *info)
+{
+    GString *str = g_string_new(NULL);
+    gchar **attributes;
+    gint i;
 
-            icon = g_hash_table_lookup(fmanager->priv->icons, file);
-            if(icon) {
-                GList *item = NULL;
+    if(!info)
+        return g_string_free(str, FALSE);
 
-                /* find out if the icon was pending creation */
-                if(fmanager->priv->pending_icons)
-                    item = g_queue_find(fmanager->priv->pending_icons, icon);
+    /* GFileInfo keeps its attributes sorted, so the order is stable */
+    attributes = g_file_info_list_attributes(info, "metadata");
+    for(i = 0; attributes && attributes[i]; ++i) {
+        gchar *value = g_file_info_get_attribute_as_string(info, attributes[i]);
+        g_string_append_printf(str, "%s=%s\n", attributes[i], value ? value : "");
+        g_free(value);
+    }
+    g_strfreev(attributes);
 
-                if(item) {
-                    /* Icon was pending creation, dequeue the thumbnail and
-                     * remove it from the pending icons queue */
-                    xfdesktop_thumbnailer_dequeue_thumbnail(fmanager->priv->thumbnailer,
-                                                            filename);
+    return g_string_free(str, FALSE);
+}
 
-                    g_queue_remove(fmanager->priv->pending_icons, icon);
-                } else {
-                    /* Always try to remove thumbnail so it doesn't take up
-                     * space on the user's disk. */
-                    xfdesktop_thumbnailer_delete_thumbnail(fmanager->priv->thumbnailer,
-                                                           filename);
-
-                    /* Remove icon from the icon view */
-                    xfdesktop_icon_view_remove_item(fmanager->priv->icon_view,
-                                                    XFDESKTOP_ICON(icon));
-                }
+static void
+xfdesktop_file_icon_manager_metadata_icon_ready(GObject *source,
+                                                GAsyncResult *result,
+                                                gpointer user_data)
+{
+    XfdesktopFileIcon *icon = XFDESKTOP_FILE_ICON(user_data);
+    GFileInfo *file_info;
 
-                /* always remove from the hash table */
-                g_hash_table_remove(fmanager->priv->icons, file);
-            } else {
-                if(g_file_equal(file, fmanager->priv->folder)) {
-                    DBG("~/Desktop disappeared!");
-                    /* yes, refresh before and after is correct */
-                    xfdesktop_file_icon_manager_refresh_icons(fmanager);
-                    xfdesktop_file_icon_manager_check_create_desktop_folder(fmanager->priv->folder);
-                    xfdesktop_file_icon_manager_refresh_icons(fmanager);
-                }
+    file_info = g_file_query_info_finish(G_FILE(source), result, NULL);
+    if(file_info) {
+        /* update the icon if the file still exists */
+        xfdesktop_file_icon_update_file_info(icon, file_info);
+        g_object_unref(file_info);
+    }
+
+    g_object_unref(icon);
+}
+
+static void xfdesktop_file_icon_manager_metadata_next_batch(XfdesktopMetadataRefresh *refresh);
+
+static void
+xfdesktop_file_icon_manager_metadata_ready(GObject *source,
+                                           GAsyncResult *result,
+                                           gpointer user_data)
+{
+    XfdesktopMetadataRefresh *refresh = user_data;
+    GFileInfo *metadata;
+
+    metadata = g_file_query_info_finish(G_FILE(source), result, NULL);
+
+    if(metadata && !g_cancellable_is_cancelled(refresh->cancellable)) {
+        XfdesktopFileIconManager *fmanager = refresh->fmanager;
+        XfdesktopFileIcon *icon = g_hash_table_lookup(fmanager->priv->icons, source);
+
+        fmanager->priv->metadata_queried++;
+
+        if(icon) {
+            gchar *old = xfdesktop_file_icon_manager_metadata_string(xfdesktop_file_icon_peek_file_info(icon));
+            gchar *new = xfdesktop_file_icon_manager_metadata_string(metadata);
+
+            /* only icons whose emblems, custom icon etc. actually changed
+             * get their info reloaded */
+            if(strcmp(old, new)) {
+                fmanager->priv->metadata_changed++;
+                g_file_query_info_async(G_FILE(source), XFDESKTOP_FILE_INFO_NAMESPACE,
+                                        G_FILE_QUERY_INFO_NONE, G_PRIORITY_DEFAULT,
+                                        NULL,
+                                        xfdesktop_file_icon_manager_metadata_icon_ready,
+                                        g_object_ref(icon));
             }
 
-            if(filename)
-                g_free(filename);
-            break;
-        default:
-            break;
+            g_free(old);
+            g_free(new);
+        }
     }
+
+    if(metadata)
+        g_object_unref(metadata);
+
+    if(--refresh->outstanding == 0)
+        xfdesktop_file_icon_manager_metadata_next_batch(refresh);
 }
 
 static void
-xfdesktop_file_icon_manager_update_file_info(gpointer key,
-                                             gpointer value,
-                                             gpointer user_data)
+xfdesktop_file_icon_manager_metadata_next_batch(XfdesktopMetadataRefresh *refresh)
 {
-    XfdesktopFileIcon *icon = XFDESKTOP_FILE_ICON(value);
-    GFileInfo *file_info;
+    gint n;
 
-    if(icon) {
-        file_info = g_file_query_info(key, XFDESKTOP_FILE_INFO_NAMESPACE,
-                                      G_FILE_QUERY_INFO_NONE, NULL, NULL);
+    if(g_cancellable_is_cancelled(refresh->cancellable)) {
+        g_list_foreach(refresh->files, (GFunc)g_object_unref, NULL);
+        g_list_free(refresh->files);
+        refresh->files = NULL;
+    }
+
+    if(!refresh->files) {
+        if(!g_cancellable_is_cancelled(refresh->cancellable)) {
+            XfdesktopFileIconManager *fmanager = refresh->fmanager;
 
-        if(file_info) {
-            /* update the icon if the file still exists */
-            xfdesktop_file_icon_update_file_info(icon, file_info);
-            g_object_unref(file_info);
+            DBG("metadata: %u icons re-queried, %u changed",
+                fmanager->priv->metadata_queried, fmanager->priv->metadata_changed);
+            fmanager->priv->metadata_refresh = NULL;
         }
+
+        g_object_unref(refresh->cancellable);
+        g_slice_free(XfdesktopMetadataRefresh, refresh);
+        return;
+    }
+
+    for(n = 0; n < METADATA_BATCH && refresh->files; ++n) {
+        GFile *file = refresh->files->data;
+
+        refresh->files = g_list_delete_link(refresh->files, refresh->files);
+        refresh->outstanding++;
+
+        g_file_query_info_async(file, "metadata::*", G_FILE_QUERY_INFO_NONE,
+                                G_PRIORITY_LOW, refresh->cancellable,
+                                xfdesktop_file_icon_manager_metadata_ready,
+                                refresh);
+        g_object_unref(file);
     }
 }
 
@@ -2573,13 +3125,25 @@ static gboolean
 xfdesktop_file_icon_manager_metadata_timer(gpointer user_data)
 {
     XfdesktopFileIconManager *fmanager = XFDESKTOP_FILE_ICON_MANAGER(user_data);
+    XfdesktopMetadataRefresh *refresh;
+    GList *l;
 
-    g_hash_table_foreach(fmanager->priv->icons,
-                         (GHFunc)xfdesktop_file_icon_manager_update_file_info,
-                         fmanager);
+    /* still busy with the last change; look again later */
+    if(fmanager->priv->metadata_refresh)
+        return TRUE;
 
     fmanager->priv->metadata_timer = 0;
 
+    refresh = g_slice_new0(XfdesktopMetadataRefresh);
+    refresh->fmanager = fmanager;
+    refresh->cancellable = g_object_ref(fmanager->priv->events_cancellable);
+    refresh->files = g_hash_table_get_keys(fmanager->priv->icons);
+    for(l = refresh->files; l; l = l->next)
+        g_object_ref(l->data);
+
+    fmanager->priv->metadata_refresh = refresh;
+    xfdesktop_file_icon_manager_metadata_next_batch(refresh);
+
     return FALSE;
 }
 
@@ -2619,6 +3183,49 @@ xfdesktop_file_icon_manager_metadata_changed(GFileMonitor     *monitor,
     }
 }
 
+static void xfdesktop_file_icon_manager_files_ready(GFileEnumerator *enumerator,
+                                                    GAsyncResult *result,
+                                                    gpointer user_data);
+
+static void
+xfdesktop_file_icon_manager_launcher_ready(GFile *file,
+                                           GFileInfo *info,
+                                           const XfdesktopDesktopEntry *entry,
+                                           const GError *error,
+                                           gpointer user_data)
+{
+    XfdesktopLauncherLoad *load = user_data;
+
+    /* a launcher deleted while it was being read gets its own deleted
+     * event; adding it now would leave an icon for a file that's gone.
+     * one that can't be read for any other reason is still shown, like
+     * any other file, without trying to read it again */
+    if(!g_cancellable_is_cancelled(load->cancellable)
+       && !g_error_matches(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND)
+       && xfdesktop_desktop_entry_should_show(entry)
+       && !g_hash_table_lookup(load->fmanager->priv->icons, file))
+    {
+        xfdesktop_file_icon_manager_add_regular_icon(load->fmanager,
+                                                     file, info,
+                                                     -1, -1,
+                                                     TRUE, FALSE);
+    }
+
+    g_object_unref(load->cancellable);
+    g_slice_free(XfdesktopLauncherLoad, load);
+}
+
+static void
+xfdesktop_file_icon_manager_next_files(XfdesktopFileIconManager *fmanager)
+{
+    fmanager->priv->enumerator_requested = g_get_monotonic_time();
+    g_file_enumerator_next_files_async(fmanager->priv->enumerator,
+                                       fmanager->priv->enumerator_batch,
+                                       G_PRIORITY_DEFAULT, NULL,
+                                       (GAsyncReadyCallback) xfdesktop_file_icon_manager_files_ready,
+                                       fmanager);
+}
+
 static void
 xfdesktop_file_icon_manager_files_ready(GFileEnumerator *enumerator,
                                         GAsyncResult *result,
@@ -2640,6 +3247,15 @@ xfdesktop_file_icon_manager_files_ready(GFileEnumerator *enumerator,
 
     files = g_file_enumerator_next_files_finish(enumerator, result, &error);
 
+    /* read more at a time while the folder keeps up */
+    if(g_get_monotonic_time() - fmanager->priv->enumerator_requested < ENUMERATE_LATENCY) {
+        fmanager->priv->enumerator_batch = MIN(fmanager->priv->enumerator_batch * 2,
+                                               ENUMERATE_BATCH_MAX);
+    } else {
+        fmanager->priv->enumerator_batch = MAX(fmanager->priv->enumerator_batch / 2,
+                                               ENUMERATE_BATCH_MIN);
+    }
+
     if(!files) {
         if(error) {
             GtkWidget *toplevel = gtk_widget_get_toplevel(GTK_WIDGET(fmanager->priv->icon_view));
@@ -2695,10 +3311,25 @@ xfdesktop_file_icon_manager_files_ready(GFileEnumerator *enumerator,
                 const gchar *name = g_file_info_get_name(l->data);
                 GFile *file = g_file_get_child(fmanager->priv->folder, name);
 
-                xfdesktop_file_icon_manager_add_regular_icon(fmanager, 
-                                                             file, l->data,
-                                                             -1, -1,
-                                                             TRUE);
+                if(xfdesktop_file_utils_is_desktop_file(l->data)
+                   || g_str_has_suffix(name, ".desktop"))
+                {
+                    /* read launchers in the background before adding them,
+                     * so a desktop full of them doesn't block on disk */
+                    XfdesktopLauncherLoad *load = g_slice_new0(XfdesktopLauncherLoad);
+
+                    load->fmanager = fmanager;
+                    load->cancellable = g_object_ref(fmanager->priv->events_cancellable);
+                    xfdesktop_desktop_entry_load_async(file, l->data,
+                                                       load->cancellable,
+                                                       xfdesktop_file_icon_manager_launcher_ready,
+                                                       load);
+                } else {
+                    xfdesktop_file_icon_manager_add_regular_icon(fmanager, 
+                                                                 file, l->data,
+                                                                 -1, -1,
+                                                                 TRUE, TRUE);
+                }
 
                 g_object_unref(file);
             }
@@ -2708,10 +3339,7 @@ xfdesktop_file_icon_manager_files_ready(GFileEnumerator *enumerator,
 
         g_list_free(files);
 
-        g_file_enumerator_next_files_async(fmanager->priv->enumerator,
-                                           10, G_PRIORITY_DEFAULT, NULL,
-                                           (GAsyncReadyCallback) xfdesktop_file_icon_manager_files_ready,
-                                           fmanager);
+        xfdesktop_file_icon_manager_next_files(fmanager);
     }
 }
 
@@ -2730,40 +3358,40 @@ xfdesktop_file_icon_manager_load_desktop_folder(XfdesktopFileIconManager *fmanag
                                                            NULL, NULL);
 
     if(fmanager->priv->enumerator) {
-        g_file_enumerator_next_files_async(fmanager->priv->enumerator,
-                                           10, G_PRIORITY_DEFAULT, NULL,
-                                           (GAsyncReadyCallback) xfdesktop_file_icon_manager_files_ready,
-                                           fmanager);
-
+        fmanager->priv->load_start = g_get_monotonic_time();
+        fmanager->priv->enumerator_batch = ENUMERATE_BATCH_MIN;
+        xfdesktop_file_icon_manager_next_files(fmanager);
     }
 }
 
 static void
-xfdesktop_file_icon_manager_check_icons_opacity(gpointer key,
-                                                gpointer value,
-                                                gpointer data)
+xfdesktop_file_icon_manager_set_icons_opacity(XfdesktopFileIconManager *fmanager,
+                                              GList *files,
+                                              guint opacity)
 {
-    XfdesktopRegularFileIcon *icon = XFDESKTOP_REGULAR_FILE_ICON(value);
-    XfdesktopClipboardManager *cmanager = XFDESKTOP_CLIPBOARD_MANAGER(data);
-    
-    if(G_UNLIKELY(xfdesktop_clipboard_manager_has_cutted_file(cmanager, XFDESKTOP_FILE_ICON(icon))))
-        xfdesktop_regular_file_icon_set_pixbuf_opacity(icon, 50);
-    else
-        xfdesktop_regular_file_icon_set_pixbuf_opacity(icon, 100);
+    GList *l;
+
+    for(l = files; l; l = l->next) {
+        XfdesktopRegularFileIcon *icon = g_hash_table_lookup(fmanager->priv->icons,
+                                                             l->data);
+        if(icon)
+            xfdesktop_regular_file_icon_set_pixbuf_opacity(icon, opacity);
+    }
 }
 
 static void
-xfdesktop_file_icon_manager_clipboard_changed(XfdesktopClipboardManager *cmanager,
-                                              gpointer user_data)
+xfdesktop_file_icon_manager_clipboard_cut_changed(XfdesktopClipboardManager *cmanager,
+                                                  GList *added,
+                                                  GList *removed,
+                                                  gpointer user_data)
 {
     XfdesktopFileIconManager *fmanager = XFDESKTOP_FILE_ICON_MANAGER(user_data);
     
     TRACE("entering");
     
-    /* slooow? */
-    g_hash_table_foreach(fmanager->priv->icons,
-                         xfdesktop_file_icon_manager_check_icons_opacity,
-                         cmanager);
+    /* only the icons whose cut state flipped */
+    xfdesktop_file_icon_manager_set_icons_opacity(fmanager, removed, 100);
+    xfdesktop_file_icon_manager_set_icons_opacity(fmanager, added, 50);
 }
 
 static void
@@ -2892,6 +3520,10 @@ xfdesktop_file_icon_manager_real_init(XfdesktopIconViewManager *manager,
                      fmanager);
     
     fmanager->priv->gscreen = gtk_widget_get_screen(GTK_WIDGET(icon_view));
+
+    fmanager->priv->position_store = xfdesktop_position_store_new(gdk_screen_get_number(fmanager->priv->gscreen));
+
+    fmanager->priv->events_cancellable = g_cancellable_new();
     
     if(!clipboard_manager) {
         GdkDisplay *gdpy = gdk_screen_get_display(fmanager->priv->gscreen);
@@ -2901,8 +3533,8 @@ xfdesktop_file_icon_manager_real_init(XfdesktopIconViewManager *manager,
     } else
         g_object_ref(G_OBJECT(clipboard_manager));
     
-    g_signal_connect(G_OBJECT(clipboard_manager), "changed",
-                     G_CALLBACK(xfdesktop_file_icon_manager_clipboard_changed),
+    g_signal_connect(G_OBJECT(clipboard_manager), "cut-changed",
+                     G_CALLBACK(xfdesktop_file_icon_manager_clipboard_cut_changed),
                      fmanager);
     
     xfdesktop_icon_view_set_selection_mode(icon_view, GTK_SELECTION_MULTIPLE);
@@ -2999,9 +3631,69 @@ xfdesktop_file_icon_manager_fini(XfdesktopIconViewManager *manager)
         fmanager->priv->save_icons_id = 0;
         xfdesktop_file_icon_manager_save_icons(fmanager);
     }
+
+    if(fmanager->priv->metadata_timer) {
+        g_source_remove(fmanager->priv->metadata_timer);
+        fmanager->priv->metadata_timer = 0;
+    }
+    /* cancelled along with the file events below */
+    fmanager->priv->metadata_refresh = NULL;
+
+    /* drop file events that haven't been handled yet */
+    if(fmanager->priv->pending_events_id) {
+        g_source_remove(fmanager->priv->pending_events_id);
+        fmanager->priv->pending_events_id = 0;
+    }
+    if(fmanager->priv->pending_events) {
+        g_hash_table_destroy(fmanager->priv->pending_events);
+        fmanager->priv->pending_events = NULL;
+    }
+    g_cancellable_cancel(fmanager->priv->events_cancellable);
+    g_object_unref(fmanager->priv->events_cancellable);
+    fmanager->priv->events_cancellable = NULL;
+    /* batches still waiting on file info free themselves once it comes
+     * back cancelled; the ones only waiting on an older batch go now */
+    while(!g_queue_is_empty(&fmanager->priv->event_batches)) {
+        XfdesktopFileEventBatch *batch = g_queue_pop_head(&fmanager->priv->event_batches);
+        if(batch->outstanding == 0)
+            xfdesktop_file_icon_manager_file_event_batch_free(batch);
+    }
+    DBG("file events: %u received, %u coalesced, %u applied",
+        fmanager->priv->events_received, fmanager->priv->events_coalesced,
+        fmanager->priv->events_applied);
+
+#if defined(DEBUG) && DEBUG > 0
+    {
+        guint hits, misses;
+        gsize bytes;
+
+        xfdesktop_file_utils_get_icon_cache_stats(&hits, &misses, &bytes);
+        DBG("icon cache: %u hits, %u misses (%.0f%%), %" G_GSIZE_FORMAT " bytes",
+            hits, misses, hits + misses ? 100.0 * hits / (hits + misses) : 0.0,
+            bytes);
+    }
+#endif
+
+    xfdesktop_folder_cover_save_cache();
+
+    if(fmanager->priv->position_store) {
+        gchar relpath[PATH_MAX], *path;
+
+        /* leave an rc file behind for older versions to read */
+        xfdesktop_file_icon_manager_positions_relpath(fmanager, relpath, PATH_MAX);
+        path = xfce_resource_save_location(XFCE_RESOURCE_CONFIG, relpath, TRUE);
+        if(path) {
+            xfdesktop_position_store_export_rc(xfdesktop_file_icon_manager_get_position_store(fmanager),
+                                               path);
+            g_free(path);
+        }
+
+        xfdesktop_position_store_free(fmanager->priv->position_store);
+        fmanager->priv->position_store = NULL;
+    }
     
     g_signal_handlers_disconnect_by_func(G_OBJECT(clipboard_manager),
-                                         G_CALLBACK(xfdesktop_file_icon_manager_clipboard_changed),
+                                         G_CALLBACK(xfdesktop_file_icon_manager_clipboard_cut_changed),
                                          fmanager);
     
     g_object_unref(G_OBJECT(clipboard_manager));
@@ -3034,8 +3726,7 @@ xfdesktop_file_icon_manager_fini(XfdesktopIconViewManager *manager)
     /* Free anything left in the pending_icons queue */
     if(fmanager->priv->pending_icons) {
         g_queue_foreach(fmanager->priv->pending_icons, (GFunc)g_object_unref, NULL);
-        g_queue_free(fmanager->priv->pending_icons);
-        fmanager->priv->pending_icons = NULL;
+        xfdesktop_file_icon_manager_free_pending_icons(fmanager);
     }
     
     /* disconnect from the file monitor and release it */
@@ -3598,6 +4289,8 @@ xfdesktop_file_icon_manager_new(GFile *folder,
                            G_OBJECT(fmanager), "show-thumbnails");
     xfconf_g_property_bind(channel, DESKTOP_MENU_MAX_TEMPLATE_FILES, G_TYPE_INT,
                            G_OBJECT(fmanager), "max-templates");
+    xfconf_g_property_bind(channel, DESKTOP_ICONS_MAX_FOLDER_WATCHES, G_TYPE_UINT,
+                           G_OBJECT(fmanager), "max-folder-watches");
 
     return XFDESKTOP_ICON_VIEW_MANAGER(fmanager);
 }
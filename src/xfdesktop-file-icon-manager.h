@@ -24,6 +24,7 @@
 #include <glib.h>
 #include <xfconf/xfconf.h>
 
+#include "xfdesktop-folder-watcher.h"
 #include "xfdesktop-special-file-icon.h"
 #include "xfdesktop-icon-view-manager.h"
 
@@ -64,6 +65,15 @@ gboolean xfdesktop_file_icon_manager_get_cached_icon_position(
                                                     gint16 *row,
                                                     gint16 *col);
 
+void xfdesktop_file_icon_manager_watch_folder(XfdesktopFileIconManager *fmanager,
+                                              GFile *folder,
+                                              XfdesktopFolderWatchFunc func,
+                                              gpointer user_data);
+void xfdesktop_file_icon_manager_unwatch_folder(XfdesktopFileIconManager *fmanager,
+                                                GFile *folder,
+                                                XfdesktopFolderWatchFunc func,
+                                                gpointer user_data);
+
 G_END_DECLS
 
 #endif  /* __XFDESKTOP_FILE_ICON_MANAGER_H__ */
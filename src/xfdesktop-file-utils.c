@@ -58,9 +58,11 @@
 #endif
 
 #include "xfdesktop-common.h"
+#include "xfdesktop-desktop-entry.h"
 #include "xfdesktop-file-icon.h"
 #include "xfdesktop-file-manager-proxy.h"
 #include "xfdesktop-file-utils.h"
+#include "xfdesktop-pixbuf-utils.h"
 #include "xfdesktop-trash-proxy.h"
 #include "xfdesktop-thunar-proxy.h"
 
@@ -204,26 +206,17 @@ gchar *
 xfdesktop_file_utils_get_display_name(GFile *file,
                                       GFileInfo *info)
 {
-    GKeyFile *key_file;
+    const XfdesktopDesktopEntry *entry;
     gchar *display_name = NULL;
 
     g_return_val_if_fail(G_IS_FILE_INFO(info), NULL);
 
     /* check if we have a desktop entry */
     if(xfdesktop_file_utils_is_desktop_file(info)) {
-        /* try to load its data into a GKeyFile */
-        key_file = xfdesktop_file_utils_query_key_file(file, NULL, NULL);
-        if(key_file) {
-            /* try to parse the display name */
-            display_name = g_key_file_get_locale_string(key_file,
-                                                        G_KEY_FILE_DESKTOP_GROUP,
-                                                        G_KEY_FILE_DESKTOP_KEY_NAME,
-                                                        NULL,
-                                                        NULL);
-
-            /* free the key file */
-            g_key_file_free (key_file);
-        }
+        /* the parsed entry is shared with the icon and tooltip code */
+        entry = xfdesktop_desktop_entry_lookup(file, info);
+        if(entry)
+            display_name = g_strdup(entry->name);
     }
 
     /* use the default display name as a fallback */
@@ -237,6 +230,132 @@ xfdesktop_file_utils_get_display_name(GFile *file,
     return display_name;
 }
 
+/* filesystem info is the same for every file on a filesystem, so it is
+ * fetched once per id::filesystem and handed to everyone who asks.  free
+ * space and the like change over time, so entries expire. */
+#define FILESYSTEM_INFO_MAX_AGE  (60 * G_USEC_PER_SEC)
+
+typedef struct
+{
+    GFileInfo *info;
+    gint64 timestamp;
+    /* XfdesktopFilesystemInfoWaiter, while a query is running */
+    GSList *waiters;
+} XfdesktopFilesystemInfoEntry;
+
+typedef struct
+{
+    GObject *object;
+    XfdesktopFilesystemInfoFunc func;
+} XfdesktopFilesystemInfoWaiter;
+
+static GHashTable *filesystem_info_cache = NULL;
+
+static void
+xfdesktop_filesystem_info_entry_free(XfdesktopFilesystemInfoEntry *entry)
+{
+    /* entries with waiters are never removed from the cache */
+    if(entry->info)
+        g_object_unref(entry->info);
+    g_slice_free(XfdesktopFilesystemInfoEntry, entry);
+}
+
+static void
+xfdesktop_file_utils_filesystem_info_ready(GObject *source,
+                                           GAsyncResult *result,
+                                           gpointer user_data)
+{
+    gchar *filesystem_id = user_data;
+    XfdesktopFilesystemInfoEntry *entry;
+    GFileInfo *info;
+    GSList *waiters, *l;
+
+    info = g_file_query_filesystem_info_finish(G_FILE(source), result, NULL);
+
+    entry = g_hash_table_lookup(filesystem_info_cache, filesystem_id);
+    g_free(filesystem_id);
+
+    if(entry->info)
+        g_object_unref(entry->info);
+    entry->info = info;
+    entry->timestamp = g_get_monotonic_time();
+
+    waiters = g_slist_reverse(entry->waiters);
+    entry->waiters = NULL;
+
+    for(l = waiters; l; l = l->next) {
+        XfdesktopFilesystemInfoWaiter *waiter = l->data;
+
+        waiter->func(waiter->object, info);
+        g_object_unref(waiter->object);
+        g_slice_free(XfdesktopFilesystemInfoWaiter, waiter);
+    }
+    g_slist_free(waiters);
+}
+
+/* calls @func with the filesystem info for @file, whose file info is @info.
+ * if it's cached @func runs right away, otherwise once it has been fetched
+ * asynchronously; @object is kept alive until then.  @func may get NULL if
+ * the filesystem can't be queried. */
+void
+xfdesktop_file_utils_get_filesystem_info(GFile *file,
+                                         GFileInfo *info,
+                                         GObject *object,
+                                         XfdesktopFilesystemInfoFunc func)
+{
+    XfdesktopFilesystemInfoEntry *entry;
+    XfdesktopFilesystemInfoWaiter *waiter;
+    const gchar *filesystem_id;
+
+    g_return_if_fail(G_IS_FILE(file) && G_IS_FILE_INFO(info));
+    g_return_if_fail(G_IS_OBJECT(object) && func);
+
+    filesystem_id = g_file_info_get_attribute_string(info,
+                                                     G_FILE_ATTRIBUTE_ID_FILESYSTEM);
+    if(!filesystem_id) {
+        /* nothing to share it under; shouldn't happen for local files */
+        GFileInfo *fs_info = g_file_query_filesystem_info(file,
+                                                          XFDESKTOP_FILESYSTEM_INFO_NAMESPACE,
+                                                          NULL, NULL);
+        func(object, fs_info);
+        if(fs_info)
+            g_object_unref(fs_info);
+        return;
+    }
+
+    if(!filesystem_info_cache) {
+        filesystem_info_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                                      (GDestroyNotify)xfdesktop_filesystem_info_entry_free);
+    }
+
+    entry = g_hash_table_lookup(filesystem_info_cache, filesystem_id);
+    if(!entry) {
+        entry = g_slice_new0(XfdesktopFilesystemInfoEntry);
+        g_hash_table_insert(filesystem_info_cache, g_strdup(filesystem_id), entry);
+    }
+
+    if(entry->info && !entry->waiters
+       && g_get_monotonic_time() - entry->timestamp < FILESYSTEM_INFO_MAX_AGE)
+    {
+        func(object, entry->info);
+        return;
+    }
+
+    waiter = g_slice_new(XfdesktopFilesystemInfoWaiter);
+    waiter->object = g_object_ref(object);
+    waiter->func = func;
+
+    /* only the first one to ask starts the query */
+    if(!entry->waiters) {
+        g_file_query_filesystem_info_async(file,
+                                           XFDESKTOP_FILESYSTEM_INFO_NAMESPACE,
+                                           G_PRIORITY_DEFAULT, NULL,
+                                           xfdesktop_file_utils_filesystem_info_ready,
+                                           g_strdup(filesystem_id));
+    }
+    entry->waiters = g_slist_prepend(entry->waiters, waiter);
+}
+
 GList *
 xfdesktop_file_utils_file_icon_list_to_file_list(GList *icon_list)
 {
@@ -360,6 +479,213 @@ xfdesktop_file_utils_get_fallback_icon(gint size)
     return g_object_ref(G_OBJECT(xfdesktop_fallback_icon));
 }
 
+/* themed icons look the same for every file of a type, so their final
+ * pixbufs (emblems and opacity included) are shared between all icons
+ * that ask for the same thing, up to a memory budget */
+#define ICON_CACHE_MAX_BYTES  (8 * 1024 * 1024)
+
+typedef struct
+{
+    /* the full icon, emblems and all */
+    GIcon *gicon;
+    gint width;
+    gint height;
+    guint opacity;
+
+    GdkPixbuf *pix;
+    gsize bytes;
+    GList *lru_link;
+} XfdesktopIconCacheEntry;
+
+/* XfdesktopIconCacheEntry -> itself, most recently used first in the LRU */
+static GHashTable *icon_cache = NULL;
+static GQueue icon_cache_lru = G_QUEUE_INIT;
+static gsize icon_cache_bytes = 0;
+static guint icon_cache_hits = 0;
+static guint icon_cache_misses = 0;
+
+static guint
+xfdesktop_icon_cache_entry_hash(gconstpointer key)
+{
+    const XfdesktopIconCacheEntry *entry = key;
+
+    return g_icon_hash((gpointer)entry->gicon)
+           ^ (entry->width << 20) ^ (entry->height << 8) ^ entry->opacity;
+}
+
+static gboolean
+xfdesktop_icon_cache_entry_equal(gconstpointer a,
+                                 gconstpointer b)
+{
+    const XfdesktopIconCacheEntry *entry_a = a, *entry_b = b;
+
+    return entry_a->width == entry_b->width
+           && entry_a->height == entry_b->height
+           && entry_a->opacity == entry_b->opacity
+           && g_icon_equal(entry_a->gicon, entry_b->gicon);
+}
+
+static void
+xfdesktop_icon_cache_entry_free(XfdesktopIconCacheEntry *entry)
+{
+    g_queue_delete_link(&icon_cache_lru, entry->lru_link);
+    icon_cache_bytes -= entry->bytes;
+
+    g_object_unref(entry->gicon);
+    g_object_unref(entry->pix);
+    g_slice_free(XfdesktopIconCacheEntry, entry);
+}
+
+static void
+xfdesktop_icon_cache_flush(GtkIconTheme *itheme,
+                           gpointer user_data)
+{
+    DBG("icon theme changed, dropping %u cached icons (%" G_GSIZE_FORMAT " bytes)",
+        g_hash_table_size(icon_cache), icon_cache_bytes);
+
+    g_hash_table_remove_all(icon_cache);
+}
+
+static GdkPixbuf *
+xfdesktop_icon_cache_lookup(GIcon *icon,
+                            gint width,
+                            gint height,
+                            guint opacity)
+{
+    XfdesktopIconCacheEntry key, *entry;
+
+    if(!icon_cache) {
+        icon_cache = g_hash_table_new_full(xfdesktop_icon_cache_entry_hash,
+                                           xfdesktop_icon_cache_entry_equal,
+                                           NULL,
+                                           (GDestroyNotify)xfdesktop_icon_cache_entry_free);
+        g_signal_connect(G_OBJECT(gtk_icon_theme_get_default()), "changed",
+                         G_CALLBACK(xfdesktop_icon_cache_flush), NULL);
+    }
+
+    key.gicon = icon;
+    key.width = width;
+    key.height = height;
+    key.opacity = opacity;
+
+    entry = g_hash_table_lookup(icon_cache, &key);
+    if(!entry) {
+        icon_cache_misses++;
+        return NULL;
+    }
+
+    icon_cache_hits++;
+    g_queue_unlink(&icon_cache_lru, entry->lru_link);
+    g_queue_push_head_link(&icon_cache_lru, entry->lru_link);
+
+    return g_object_ref(entry->pix);
+}
+
+static void
+xfdesktop_icon_cache_insert(GIcon *icon,
+                            gint width,
+                            gint height,
+                            guint opacity,
+                            GdkPixbuf *pix)
+{
+    XfdesktopIconCacheEntry *entry = g_slice_new0(XfdesktopIconCacheEntry);
+
+    entry->gicon = g_object_ref(icon);
+    entry->width = width;
+    entry->height = height;
+    entry->opacity = opacity;
+    entry->pix = g_object_ref(pix);
+    entry->bytes = gdk_pixbuf_get_rowstride(pix) * gdk_pixbuf_get_height(pix);
+
+    g_queue_push_head(&icon_cache_lru, entry);
+    entry->lru_link = icon_cache_lru.head;
+    icon_cache_bytes += entry->bytes;
+
+    /* replaces an equal entry, if any */
+    g_hash_table_replace(icon_cache, entry, entry);
+
+    while(icon_cache_bytes > ICON_CACHE_MAX_BYTES
+          && g_queue_peek_tail(&icon_cache_lru) != entry)
+    {
+        g_hash_table_remove(icon_cache, g_queue_peek_tail(&icon_cache_lru));
+    }
+}
+
+/* hit rate of the shared icon cache and how much memory it holds */
+void
+xfdesktop_file_utils_get_icon_cache_stats(guint *hits,
+                                          guint *misses,
+                                          gsize *bytes)
+{
+    if(hits)
+        *hits = icon_cache_hits;
+    if(misses)
+        *misses = icon_cache_misses;
+    if(bytes)
+        *bytes = icon_cache_bytes;
+}
+
+/* adds @icon's emblems and @opacity to @pix, which must be writable.
+ * takes over the reference to @pix and returns the result. */
+static GdkPixbuf *
+xfdesktop_file_utils_finish_icon(GdkPixbuf *pix,
+                                 GIcon *icon,
+                                 guint opacity)
+{
+    /* Add the emblems */
+    if(G_IS_EMBLEMED_ICON(icon))
+        xfdesktop_file_utils_add_emblems(pix, g_emblemed_icon_get_emblems(G_EMBLEMED_ICON(icon)));
+
+    if(opacity != 100) {
+        GdkPixbuf *tmp = xfdesktop_pixbuf_lucent(pix, opacity);
+        g_object_unref(G_OBJECT(pix));
+        pix = tmp;
+    }
+
+    return pix;
+}
+
+/* decodes a file or loadable icon at the given size.  doesn't touch the
+ * icon theme, so it's safe to call from any thread. */
+GdkPixbuf *
+xfdesktop_file_utils_load_loadable_icon(GIcon *icon,
+                                        gint width,
+                                        gint height,
+                                        GCancellable *cancellable)
+{
+    GInputStream *stream;
+    GdkPixbuf *pix = NULL;
+
+    g_return_val_if_fail(G_IS_LOADABLE_ICON(icon), NULL);
+
+    stream = g_loadable_icon_load(G_LOADABLE_ICON(icon), MIN(width, height),
+                                  NULL, cancellable, NULL);
+    if(stream) {
+        pix = gdk_pixbuf_new_from_stream_at_scale(stream, width, height, TRUE,
+                                                  cancellable, NULL);
+        g_object_unref(stream);
+    }
+
+    return pix;
+}
+
+/* finishes a pixbuf loaded for @icon's base icon by adding @icon's emblems
+ * and @opacity.  @pix itself is left alone. */
+GdkPixbuf *
+xfdesktop_file_utils_decorate_icon(GdkPixbuf *pix,
+                                   GIcon *icon,
+                                   guint opacity)
+{
+    g_return_val_if_fail(GDK_IS_PIXBUF(pix), NULL);
+
+    if(!G_IS_EMBLEMED_ICON(icon) && opacity == 100)
+        return g_object_ref(pix);
+
+    return xfdesktop_file_utils_finish_icon(gdk_pixbuf_copy(pix), icon, opacity);
+}
+
+/* the returned pixbuf may be shared with other icons and must not be
+ * modified */
 GdkPixbuf *
 xfdesktop_file_utils_get_icon(GIcon *icon,
                               gint width,
@@ -382,6 +708,14 @@ xfdesktop_file_utils_get_icon(GIcon *icon,
     if(!base_icon)
         return NULL;
 
+    /* file and loadable icons (thumbnails, covers) can change on disk
+     * without their GIcon changing, so only themed ones are shared */
+    if(G_IS_THEMED_ICON(base_icon)) {
+        pix = xfdesktop_icon_cache_lookup(icon, width, height, opacity);
+        if(pix)
+            return pix;
+    }
+
     if(G_IS_THEMED_ICON(base_icon)) {
       GtkIconInfo *icon_info = gtk_icon_theme_lookup_by_gicon(itheme,
                                                               base_icon, size,
@@ -391,12 +725,7 @@ xfdesktop_file_utils_get_icon(GIcon *icon,
           gtk_icon_info_free(icon_info);
       }
     } else if(G_IS_LOADABLE_ICON(base_icon)) {
-        GInputStream *stream = g_loadable_icon_load(G_LOADABLE_ICON(base_icon),
-                                                    size, NULL, NULL, NULL);
-        if(stream) {
-            pix = gdk_pixbuf_new_from_stream_at_scale(stream, width, height, TRUE, NULL, NULL);
-            g_object_unref(stream);
-        }
+        pix = xfdesktop_file_utils_load_loadable_icon(base_icon, width, height, NULL);
     } else if(G_IS_FILE_ICON(base_icon)) {
         GFile *file = g_file_icon_get_file(G_FILE_ICON(icon));
         gchar *path = g_file_get_path(file);
@@ -432,30 +761,212 @@ xfdesktop_file_utils_get_icon(GIcon *icon,
         return NULL;
     }
 
-    /* Add the emblems */
-    if(G_IS_EMBLEMED_ICON(icon))
-        xfdesktop_file_utils_add_emblems(pix, g_emblemed_icon_get_emblems(G_EMBLEMED_ICON(icon)));
-
-    if(opacity != 100) {
-        GdkPixbuf *tmp = exo_gdk_pixbuf_lucent(pix, opacity);
+    /* don't draw on the shared fallback icon */
+    if(G_UNLIKELY(pix == xfdesktop_fallback_icon) && G_IS_EMBLEMED_ICON(icon)) {
+        GdkPixbuf *tmp = gdk_pixbuf_copy(pix);
         g_object_unref(G_OBJECT(pix));
         pix = tmp;
     }
 
+    pix = xfdesktop_file_utils_finish_icon(pix, icon, opacity);
+
+    if(G_IS_THEMED_ICON(base_icon))
+        xfdesktop_icon_cache_insert(icon, width, height, opacity, pix);
+
     return pix;
 }
 
+/* emblems come from a handful of theme icons drawn at a handful of sizes,
+ * so each one is looked up, loaded and scaled only once per icon theme */
+typedef struct
+{
+    GIcon *gicon;
+    gint size;
+} XfdesktopEmblemCacheKey;
+
+typedef struct
+{
+    GdkPixbuf *pix;
+    gint x;
+    gint y;
+} XfdesktopEmblemPlacement;
+
+/* XfdesktopEmblemCacheKey -> GdkPixbuf, or NULL if the theme doesn't have
+ * that emblem */
+static GHashTable *emblem_cache = NULL;
+
+static guint
+xfdesktop_emblem_cache_key_hash(gconstpointer key)
+{
+    const XfdesktopEmblemCacheKey *emblem_key = key;
+
+    return g_icon_hash((gpointer)emblem_key->gicon) ^ emblem_key->size;
+}
+
+static gboolean
+xfdesktop_emblem_cache_key_equal(gconstpointer a,
+                                 gconstpointer b)
+{
+    const XfdesktopEmblemCacheKey *key_a = a, *key_b = b;
+
+    return key_a->size == key_b->size
+           && g_icon_equal(key_a->gicon, key_b->gicon);
+}
+
 static void
-xfdesktop_file_utils_add_emblems(GdkPixbuf *pix, GList *emblems)
+xfdesktop_emblem_cache_key_free(XfdesktopEmblemCacheKey *key)
+{
+    g_object_unref(key->gicon);
+    g_slice_free(XfdesktopEmblemCacheKey, key);
+}
+
+static void
+xfdesktop_emblem_cache_value_free(GdkPixbuf *emblem_pix)
 {
+    if(emblem_pix)
+        g_object_unref(emblem_pix);
+}
+
+static void
+xfdesktop_emblem_cache_flush(GtkIconTheme *itheme,
+                             gpointer user_data)
+{
+    g_hash_table_remove_all(emblem_cache);
+}
+
+/* returns @emblem as a @size x @size pixbuf with an alpha channel, or NULL
+ * if the theme doesn't have it.  the pixbuf belongs to the cache. */
+static GdkPixbuf *
+xfdesktop_emblem_cache_lookup(GIcon *emblem,
+                              gint size)
+{
+    XfdesktopEmblemCacheKey key, *new_key;
+    GtkIconInfo *icon_info;
     GdkPixbuf *emblem_pix = NULL;
+    gpointer cached;
+
+    if(!emblem_cache) {
+        emblem_cache = g_hash_table_new_full(xfdesktop_emblem_cache_key_hash,
+                                             xfdesktop_emblem_cache_key_equal,
+                                             (GDestroyNotify)xfdesktop_emblem_cache_key_free,
+                                             (GDestroyNotify)xfdesktop_emblem_cache_value_free);
+        g_signal_connect(G_OBJECT(gtk_icon_theme_get_default()), "changed",
+                         G_CALLBACK(xfdesktop_emblem_cache_flush), NULL);
+    }
+
+    key.gicon = emblem;
+    key.size = size;
+
+    if(g_hash_table_lookup_extended(emblem_cache, &key, NULL, &cached))
+        return cached;
+
+    icon_info = gtk_icon_theme_lookup_by_gicon(gtk_icon_theme_get_default(),
+                                               emblem, size, ITHEME_FLAGS);
+    if(icon_info) {
+        emblem_pix = gtk_icon_info_load_icon(icon_info, NULL);
+        gtk_icon_info_free(icon_info);
+    }
+
+    if(emblem_pix) {
+        if(gdk_pixbuf_get_width(emblem_pix) != size
+           || gdk_pixbuf_get_height(emblem_pix) != size)
+        {
+            GdkPixbuf *tmp = gdk_pixbuf_scale_simple(emblem_pix, size, size,
+                                                     GDK_INTERP_BILINEAR);
+            g_object_unref(emblem_pix);
+            emblem_pix = tmp;
+        }
+
+        if(!gdk_pixbuf_get_has_alpha(emblem_pix)) {
+            GdkPixbuf *tmp = gdk_pixbuf_add_alpha(emblem_pix, FALSE, 0, 0, 0);
+            g_object_unref(emblem_pix);
+            emblem_pix = tmp;
+        }
+    }
+
+    new_key = g_slice_new(XfdesktopEmblemCacheKey);
+    new_key->gicon = g_object_ref(emblem);
+    new_key->size = size;
+    g_hash_table_insert(emblem_cache, new_key, emblem_pix);
+
+    return emblem_pix;
+}
+
+/* draws all the emblems over @pix in one walk down its rows.  emblems
+ * never overlap, and each one is blended straight into the row it
+ * covers. */
+static void
+xfdesktop_file_utils_composite_emblems(GdkPixbuf *pix,
+                                       const XfdesktopEmblemPlacement *placements,
+                                       gint n_placements)
+{
+    guchar *pixels = gdk_pixbuf_get_pixels(pix);
+    gint rowstride = gdk_pixbuf_get_rowstride(pix);
+    gint n_channels = gdk_pixbuf_get_n_channels(pix);
+    gboolean has_alpha = gdk_pixbuf_get_has_alpha(pix);
+    gint pix_height = gdk_pixbuf_get_height(pix);
+    gint y, i, x;
+
+    for(y = 0; y < pix_height; ++y) {
+        for(i = 0; i < n_placements; ++i) {
+            const XfdesktopEmblemPlacement *placement = &placements[i];
+            gint emblem_width = gdk_pixbuf_get_width(placement->pix);
+            gint emblem_height = gdk_pixbuf_get_height(placement->pix);
+            const guchar *src;
+            guchar *dest;
+
+            if(y < placement->y || y >= placement->y + emblem_height)
+                continue;
+
+            src = gdk_pixbuf_get_pixels(placement->pix)
+                  + (y - placement->y) * gdk_pixbuf_get_rowstride(placement->pix);
+            dest = pixels + y * rowstride + placement->x * n_channels;
+
+            for(x = 0; x < emblem_width; ++x, src += 4, dest += n_channels) {
+                guint src_alpha = src[3];
+
+                if(src_alpha == 0)
+                    continue;
+
+                if(src_alpha == 255) {
+                    dest[0] = src[0];
+                    dest[1] = src[1];
+                    dest[2] = src[2];
+                    if(has_alpha)
+                        dest[3] = 255;
+                } else if(!has_alpha) {
+                    guint dest_weight = 255 - src_alpha;
+
+                    dest[0] = (src[0] * src_alpha + dest[0] * dest_weight + 127) / 255;
+                    dest[1] = (src[1] * src_alpha + dest[1] * dest_weight + 127) / 255;
+                    dest[2] = (src[2] * src_alpha + dest[2] * dest_weight + 127) / 255;
+                } else {
+                    /* "over" with straight alpha, everything scaled by 255 */
+                    guint src_weight = src_alpha * 255;
+                    guint dest_weight = dest[3] * (255 - src_alpha);
+                    guint out_alpha = src_weight + dest_weight;
+
+                    dest[0] = (src[0] * src_weight + dest[0] * dest_weight + out_alpha / 2) / out_alpha;
+                    dest[1] = (src[1] * src_weight + dest[1] * dest_weight + out_alpha / 2) / out_alpha;
+                    dest[2] = (src[2] * src_weight + dest[2] * dest_weight + out_alpha / 2) / out_alpha;
+                    dest[3] = (out_alpha + 127) / 255;
+                }
+            }
+        }
+    }
+}
+
+static void
+xfdesktop_file_utils_add_emblems(GdkPixbuf *pix, GList *emblems)
+{
+    XfdesktopEmblemPlacement placements[4];
+    GdkPixbuf *emblem_pix;
     gint max_emblems;
     gint pix_width, pix_height;
     gint emblem_size;
-    gint dest_x, dest_y, dest_width, dest_height;
+    gint dest_width, dest_height;
     gint position;
     GList *iter;
-    GtkIconTheme *itheme = gtk_icon_theme_get_default();
 
     g_return_if_fail(pix != NULL);
 
@@ -463,77 +974,51 @@ xfdesktop_file_utils_add_emblems(GdkPixbuf *pix, GList *emblems)
     pix_height = gdk_pixbuf_get_height(pix);
 
     emblem_size = MIN(pix_width, pix_height) / 2;
+    if(emblem_size <= 0)
+        return;
+
+    dest_width = pix_width - emblem_size;
+    dest_height = pix_height - emblem_size;
 
     /* render up to four emblems for sizes from 48 onwards, else up to 2 emblems */
     max_emblems = (pix_height < 48 && pix_width < 48) ? 2 : 4;
 
     for(iter = emblems, position = 0; iter != NULL && position < max_emblems; iter = iter->next) {
         /* extract the icon from the emblem and load it */
-        GIcon *emblem = g_emblem_get_icon(iter->data);
-        GtkIconInfo *icon_info = gtk_icon_theme_lookup_by_gicon(itheme,
-                                                                emblem,
-                                                                emblem_size,
-                                                                ITHEME_FLAGS);
-        if(icon_info) {
-            emblem_pix = gtk_icon_info_load_icon(icon_info, NULL);
-            gtk_icon_info_free(icon_info);
-        }
-
-        if(emblem_pix) {
-            if(gdk_pixbuf_get_width(emblem_pix) != emblem_size
-               || gdk_pixbuf_get_height(emblem_pix) != emblem_size)
-            {
-                GdkPixbuf *tmp = gdk_pixbuf_scale_simple(emblem_pix,
-                                                         emblem_size,
-                                                         emblem_size,
-                                                         GDK_INTERP_BILINEAR);
-                g_object_unref(emblem_pix);
-                emblem_pix = tmp;
-            }
+        emblem_pix = xfdesktop_emblem_cache_lookup(g_emblem_get_icon(iter->data),
+                                                   emblem_size);
+        if(!emblem_pix)
+            continue;
 
-            dest_width = pix_width - emblem_size;
-            dest_height = pix_height - emblem_size;
-
-            switch(position) {
-                case 0: /* bottom right */
-                    dest_x = dest_width;
-                    dest_y = dest_height;
-                    break;
-                case 1: /* bottom left */
-                    dest_x = 0;
-                    dest_y = dest_height;
-                    break;
-                case 2: /* upper right */
-                    dest_x = dest_width;
-                    dest_y = 0;
-                    break;
-                case 3: /* upper left */
-                    dest_x = dest_y = 0;
-                    break;
-                default:
-                    g_warning("Invalid emblem position in xfdesktop_file_utils_add_emblems");
-            }
+        placements[position].pix = emblem_pix;
 
-            DBG("calling gdk_pixbuf_composite(%p, %p, %d, %d, %d, %d, %d, %d, %.1f, %.1f, %d, %d) pixbuf w: %d h: %d",
-                emblem_pix, pix,
-                dest_x, dest_y,
-                emblem_size, emblem_size,
-                dest_x, dest_y,
-                1.0, 1.0, GDK_INTERP_BILINEAR, 255, pix_width, pix_height);
+        switch(position) {
+            case 0: /* bottom right */
+                placements[position].x = dest_width;
+                placements[position].y = dest_height;
+                break;
+            case 1: /* bottom left */
+                placements[position].x = 0;
+                placements[position].y = dest_height;
+                break;
+            case 2: /* upper right */
+                placements[position].x = dest_width;
+                placements[position].y = 0;
+                break;
+            case 3: /* upper left */
+                placements[position].x = placements[position].y = 0;
+                break;
+        }
 
-            /* Add the emblem */
-            gdk_pixbuf_composite(emblem_pix, pix,
-                                 dest_x, dest_y,
-                                 emblem_size, emblem_size,
-                                 dest_x, dest_y,
-                                 1.0, 1.0, GDK_INTERP_BILINEAR, 255);
+        position++;
+    }
 
-            g_object_unref(emblem_pix);
-            emblem_pix = NULL;
+    DBG("compositing %d emblems of size %d onto pixbuf w: %d h: %d",
+        position, emblem_size, pix_width, pix_height);
 
-            position++;
-        }
-    }
+    /* Add the emblems */
+    if(position > 0)
+        xfdesktop_file_utils_composite_emblems(pix, placements, position);
 }
 
 void
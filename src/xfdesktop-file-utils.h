@@ -39,6 +39,14 @@ GKeyFile *xfdesktop_file_utils_query_key_file(GFile *file,
 gchar *xfdesktop_file_utils_get_display_name(GFile *file,
                                              GFileInfo *info);
 
+typedef void (*XfdesktopFilesystemInfoFunc)(GObject *object,
+                                            GFileInfo *filesystem_info);
+
+void xfdesktop_file_utils_get_filesystem_info(GFile *file,
+                                              GFileInfo *info,
+                                              GObject *object,
+                                              XfdesktopFilesystemInfoFunc func);
+
 GList *xfdesktop_file_utils_file_icon_list_to_file_list(GList *icon_list);
 GList *xfdesktop_file_utils_file_list_from_string(const gchar *string);
 gchar *xfdesktop_file_utils_file_list_to_string(GList *file_list);
@@ -51,6 +59,16 @@ GdkPixbuf *xfdesktop_file_utils_get_icon(GIcon *icon,
                                          gint width,
                                          gint height,
                                          guint opacity);
+GdkPixbuf *xfdesktop_file_utils_load_loadable_icon(GIcon *icon,
+                                                  gint width,
+                                                  gint height,
+                                                  GCancellable *cancellable);
+GdkPixbuf *xfdesktop_file_utils_decorate_icon(GdkPixbuf *pix,
+                                              GIcon *icon,
+                                              guint opacity);
+void xfdesktop_file_utils_get_icon_cache_stats(guint *hits,
+                                               guint *misses,
+                                               gsize *bytes);
 
 void xfdesktop_file_utils_set_window_cursor(GtkWindow *window,
                                             GdkCursorType cursor_type);
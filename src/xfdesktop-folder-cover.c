@@ -0,0 +1,484 @@
+/*
+ *  xfdesktop - xfce4's desktop manager
+ *
+ *  Copyright (c) 2014 The Xfce Development Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software Foundation,
+ *  Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <stdlib.h>
+
+#include <gio/gio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include <libxfce4util/libxfce4util.h>
+
+#include "xfdesktop-folder-cover.h"
+
+#define CACHE_FILE          "xfdesktop/folder-covers"
+#define CACHE_SAVE_DELAY    5
+/* past this, entries that weren't used this session are dropped on save */
+#define CACHE_MAX_ENTRIES   4096
+
+#define SCAN_BATCH          64
+
+/* the names we look for, case-insensitively, best first */
+#define N_CANDIDATES  7
+
+/* perfect hash over the candidate names: no two of them share a slot, so
+ * checking a directory entry is one hash and at most one string compare.
+ * if you change the names, find new multipliers so that still holds. */
+#define CANDIDATE_HASH(len, c0, c1)  ((5 * (len) + 5 * (c0) + (c1)) & 7)
+
+static const struct
+{
+    const gchar *name;
+    gint priority;
+} candidate_table[8] = {
+    { "cover.jpeg",    3 },
+    { "fanart.jpg",    6 },
+    { "albumart.jpeg", 5 },
+    { "cover.jpg",     2 },
+    { "folder.jpeg",   1 },
+    { "albumart.jpg",  4 },
+    { NULL,           -1 },
+    { "folder.jpg",    0 },
+};
+
+typedef struct
+{
+    guint64 mtime;
+    /* name of the cover inside the folder, NULL if it has none */
+    gchar *cover_name;
+    gboolean used;
+} XfdesktopFolderCoverEntry;
+
+typedef struct
+{
+    GFile *folder;
+    GObject *object;
+    XfdesktopFolderCoverFunc func;
+    guint64 mtime;
+    GFileEnumerator *enumerator;
+    gchar *found[N_CANDIDATES];
+    /* whether the whole folder was read, so the result can be cached */
+    gboolean complete;
+    /* the best of found[] that's really an image, set by the sniff */
+    const gchar *cover_name;
+} XfdesktopFolderCoverScan;
+
+/* folder path -> XfdesktopFolderCoverEntry */
+static GHashTable *cover_cache = NULL;
+static guint cover_cache_save_id = 0;
+
+
+static void
+xfdesktop_folder_cover_entry_free(XfdesktopFolderCoverEntry *entry)
+{
+    g_free(entry->cover_name);
+    g_slice_free(XfdesktopFolderCoverEntry, entry);
+}
+
+static gint
+xfdesktop_folder_cover_candidate_priority(const gchar *name)
+{
+    gsize len = strlen(name);
+    gint slot;
+
+    if(len < 9 || len > 13)
+        return -1;
+
+    slot = CANDIDATE_HASH(len, g_ascii_tolower(name[0]),
+                          g_ascii_tolower(name[1]));
+
+    if(candidate_table[slot].name
+       && !g_ascii_strcasecmp(name, candidate_table[slot].name))
+    {
+        return candidate_table[slot].priority;
+    }
+
+    return -1;
+}
+
+static void
+xfdesktop_folder_cover_load_cache(void)
+{
+    gchar *filename, *contents = NULL, *line, *next;
+
+    if(cover_cache)
+        return;
+
+    cover_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                        (GDestroyNotify)xfdesktop_folder_cover_entry_free);
+
+    filename = xfce_resource_lookup(XFCE_RESOURCE_CACHE, CACHE_FILE);
+    if(!filename)
+        return;
+
+    if(g_file_get_contents(filename, &contents, NULL, NULL)) {
+        for(line = contents; line && *line; line = next) {
+            gchar **fields;
+
+            next = strchr(line, '\n');
+            if(next)
+                *next++ = '\0';
+
+            /* mtime <TAB> cover name <TAB> folder path */
+            fields = g_strsplit(line, "\t", 3);
+            if(g_strv_length(fields) == 3) {
+                XfdesktopFolderCoverEntry *entry = g_slice_new0(XfdesktopFolderCoverEntry);
+
+                entry->mtime = g_ascii_strtoull(fields[0], NULL, 10);
+                if(*fields[1])
+                    entry->cover_name = g_strcompress(fields[1]);
+                g_hash_table_replace(cover_cache, g_strcompress(fields[2]), entry);
+            }
+            g_strfreev(fields);
+        }
+
+        DBG("loaded %u folder covers from %s",
+            g_hash_table_size(cover_cache), filename);
+    }
+
+    g_free(contents);
+    g_free(filename);
+}
+
+void
+xfdesktop_folder_cover_save_cache(void)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+    gboolean prune;
+    GString *out;
+    gchar *filename;
+
+    if(cover_cache_save_id) {
+        g_source_remove(cover_cache_save_id);
+        cover_cache_save_id = 0;
+    }
+
+    if(!cover_cache)
+        return;
+
+    filename = xfce_resource_save_location(XFCE_RESOURCE_CACHE, CACHE_FILE, TRUE);
+    if(!filename)
+        return;
+
+    prune = g_hash_table_size(cover_cache) > CACHE_MAX_ENTRIES;
+
+    out = g_string_new(NULL);
+    g_hash_table_iter_init(&iter, cover_cache);
+    while(g_hash_table_iter_next(&iter, &key, &value)) {
+        XfdesktopFolderCoverEntry *entry = value;
+        gchar *path, *cover;
+
+        if(prune && !entry->used) {
+            g_hash_table_iter_remove(&iter);
+            continue;
+        }
+
+        path = g_strescape(key, NULL);
+        cover = g_strescape(entry->cover_name ? entry->cover_name : "", NULL);
+        g_string_append_printf(out, "%" G_GUINT64_FORMAT "\t%s\t%s\n",
+                               entry->mtime, cover, path);
+        g_free(cover);
+        g_free(path);
+    }
+
+    if(!g_file_set_contents(filename, out->str, out->len, NULL))
+        g_warning("Unable to write folder cover cache to %s", filename);
+
+    g_string_free(out, TRUE);
+    g_free(filename);
+}
+
+static gboolean
+xfdesktop_folder_cover_save_cache_idled(gpointer user_data)
+{
+    cover_cache_save_id = 0;
+    xfdesktop_folder_cover_save_cache();
+    return FALSE;
+}
+
+static void
+xfdesktop_folder_cover_scan_done(XfdesktopFolderCoverScan *scan,
+                                 const gchar *cover_name)
+{
+    gchar *folder_path = g_file_get_path(scan->folder);
+    gchar *cover_path = NULL;
+    gint i;
+
+    if(folder_path && cover_name)
+        cover_path = g_build_filename(folder_path, cover_name, NULL);
+
+    if(scan->complete && folder_path) {
+        XfdesktopFolderCoverEntry *entry = g_slice_new0(XfdesktopFolderCoverEntry);
+
+        entry->mtime = scan->mtime;
+        entry->cover_name = g_strdup(cover_name);
+        entry->used = TRUE;
+
+        xfdesktop_folder_cover_load_cache();
+        g_hash_table_replace(cover_cache, g_strdup(folder_path), entry);
+
+        if(!cover_cache_save_id) {
+            cover_cache_save_id = g_timeout_add_seconds(CACHE_SAVE_DELAY,
+                                                        xfdesktop_folder_cover_save_cache_idled,
+                                                        NULL);
+        }
+    }
+
+    scan->func(scan->object, cover_path);
+
+    for(i = 0; i < N_CANDIDATES; ++i)
+        g_free(scan->found[i]);
+    g_free(cover_path);
+    g_free(folder_path);
+    if(scan->enumerator)
+        g_object_unref(scan->enumerator);
+    g_object_unref(scan->object);
+    g_object_unref(scan->folder);
+    g_slice_free(XfdesktopFolderCoverScan, scan);
+}
+
+/* runs on a worker thread: the main thread leaves scan->found alone until
+ * this is done */
+static void
+xfdesktop_folder_cover_sniff_thread(GSimpleAsyncResult *result,
+                                    GObject *object,
+                                    GCancellable *cancellable)
+{
+    XfdesktopFolderCoverScan *scan = g_simple_async_result_get_op_res_gpointer(result);
+    gchar *folder_path = g_file_get_path(scan->folder);
+    gint i;
+
+    /* one sniff for the best candidate, rather than one per name we
+     * might have had */
+    for(i = 0; folder_path && i < N_CANDIDATES && !scan->cover_name; ++i) {
+        gchar *cover_path;
+
+        if(!scan->found[i])
+            continue;
+
+        cover_path = g_build_filename(folder_path, scan->found[i], NULL);
+        if(gdk_pixbuf_get_file_info(cover_path, NULL, NULL) != NULL)
+            scan->cover_name = scan->found[i];
+        g_free(cover_path);
+    }
+
+    g_free(folder_path);
+}
+
+static void
+xfdesktop_folder_cover_sniff_ready(GObject *source,
+                                   GAsyncResult *result,
+                                   gpointer user_data)
+{
+    XfdesktopFolderCoverScan *scan = user_data;
+
+    xfdesktop_folder_cover_scan_done(scan, scan->cover_name);
+}
+
+static void
+xfdesktop_folder_cover_scan_finish(XfdesktopFolderCoverScan *scan,
+                                   gboolean complete)
+{
+    GSimpleAsyncResult *result;
+    gboolean found_any = FALSE;
+    gint i;
+
+    scan->complete = complete;
+
+    for(i = 0; i < N_CANDIDATES; ++i)
+        found_any = found_any || scan->found[i] != NULL;
+
+    if(!found_any) {
+        xfdesktop_folder_cover_scan_done(scan, NULL);
+        return;
+    }
+
+    /* reading the image header is disk I/O, so it's kept off the main
+     * thread like the rest of the scan */
+    result = g_simple_async_result_new(G_OBJECT(scan->folder),
+                                       xfdesktop_folder_cover_sniff_ready,
+                                       scan,
+                                       xfdesktop_folder_cover_scan_finish);
+    g_simple_async_result_set_op_res_gpointer(result, scan, NULL);
+    g_simple_async_result_run_in_thread(result,
+                                        xfdesktop_folder_cover_sniff_thread,
+                                        G_PRIORITY_LOW, NULL);
+    g_object_unref(result);
+}
+
+static void
+xfdesktop_folder_cover_files_ready(GObject *source,
+                                   GAsyncResult *result,
+                                   gpointer user_data)
+{
+    XfdesktopFolderCoverScan *scan = user_data;
+    GError *error = NULL;
+    GList *files, *l;
+
+    files = g_file_enumerator_next_files_finish(G_FILE_ENUMERATOR(source),
+                                                result, &error);
+    if(!files) {
+        /* an error means we don't know everything that's in there */
+        xfdesktop_folder_cover_scan_finish(scan, error == NULL);
+        if(error)
+            g_error_free(error);
+        return;
+    }
+
+    for(l = files; l; l = l->next) {
+        const gchar *name = g_file_info_get_name(l->data);
+        gint priority = name ? xfdesktop_folder_cover_candidate_priority(name) : -1;
+
+        if(priority >= 0 && !scan->found[priority])
+            scan->found[priority] = g_strdup(name);
+
+        g_object_unref(l->data);
+    }
+    g_list_free(files);
+
+    g_file_enumerator_next_files_async(scan->enumerator, SCAN_BATCH,
+                                       G_PRIORITY_LOW, NULL,
+                                       xfdesktop_folder_cover_files_ready,
+                                       scan);
+}
+
+static void
+xfdesktop_folder_cover_enumerate_ready(GObject *source,
+                                       GAsyncResult *result,
+                                       gpointer user_data)
+{
+    XfdesktopFolderCoverScan *scan = user_data;
+
+    scan->enumerator = g_file_enumerate_children_finish(G_FILE(source),
+                                                        result, NULL);
+    if(!scan->enumerator) {
+        xfdesktop_folder_cover_scan_finish(scan, FALSE);
+        return;
+    }
+
+    g_file_enumerator_next_files_async(scan->enumerator, SCAN_BATCH,
+                                       G_PRIORITY_LOW, NULL,
+                                       xfdesktop_folder_cover_files_ready,
+                                       scan);
+}
+
+static void
+xfdesktop_folder_cover_mtime_ready(GObject *source,
+                                   GAsyncResult *result,
+                                   gpointer user_data)
+{
+    XfdesktopFolderCoverScan *scan = user_data;
+    GFileInfo *info;
+
+    info = g_file_query_info_finish(G_FILE(source), result, NULL);
+    if(!info) {
+        xfdesktop_folder_cover_scan_finish(scan, FALSE);
+        return;
+    }
+
+    /* taken before the scan, so a change during it invalidates the result */
+    scan->mtime = g_file_info_get_attribute_uint64(info,
+                                                   G_FILE_ATTRIBUTE_TIME_MODIFIED);
+    g_object_unref(info);
+
+    g_file_enumerate_children_async(scan->folder, G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                    G_FILE_QUERY_INFO_NONE, G_PRIORITY_LOW,
+                                    NULL,
+                                    xfdesktop_folder_cover_enumerate_ready,
+                                    scan);
+}
+
+
+/* returns TRUE if the cover of @folder is known without looking, and if so
+ * sets @cover_path to it (NULL if the folder has none) */
+gboolean
+xfdesktop_folder_cover_lookup(GFile *folder,
+                              GFileInfo *folder_info,
+                              gchar **cover_path)
+{
+    XfdesktopFolderCoverEntry *entry;
+    gchar *path;
+
+    g_return_val_if_fail(G_IS_FILE(folder) && G_IS_FILE_INFO(folder_info), FALSE);
+    g_return_val_if_fail(cover_path, FALSE);
+
+    if(!g_file_info_has_attribute(folder_info, G_FILE_ATTRIBUTE_TIME_MODIFIED))
+        return FALSE;
+
+    path = g_file_get_path(folder);
+    if(!path)
+        return FALSE;
+
+    xfdesktop_folder_cover_load_cache();
+
+    entry = g_hash_table_lookup(cover_cache, path);
+    if(!entry
+       || entry->mtime != g_file_info_get_attribute_uint64(folder_info,
+                                                           G_FILE_ATTRIBUTE_TIME_MODIFIED))
+    {
+        g_free(path);
+        return FALSE;
+    }
+
+    entry->used = TRUE;
+    *cover_path = entry->cover_name
+                  ? g_build_filename(path, entry->cover_name, NULL)
+                  : NULL;
+    g_free(path);
+
+    return TRUE;
+}
+
+/* reads @folder in the background and calls @func with the path of its
+ * cover, or NULL if it has none.  @object is kept alive until then. */
+void
+xfdesktop_folder_cover_scan(GFile *folder,
+                            GObject *object,
+                            XfdesktopFolderCoverFunc func)
+{
+    XfdesktopFolderCoverScan *scan;
+
+    g_return_if_fail(G_IS_FILE(folder) && G_IS_OBJECT(object) && func);
+
+    scan = g_slice_new0(XfdesktopFolderCoverScan);
+    scan->folder = g_object_ref(folder);
+    scan->object = g_object_ref(object);
+    scan->func = func;
+
+    g_file_query_info_async(folder, G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                            G_FILE_QUERY_INFO_NONE, G_PRIORITY_LOW, NULL,
+                            xfdesktop_folder_cover_mtime_ready, scan);
+}
+
+gboolean
+xfdesktop_folder_cover_name_is_candidate(const gchar *name)
+{
+    g_return_val_if_fail(name, FALSE);
+
+    return xfdesktop_folder_cover_candidate_priority(name) >= 0;
+}
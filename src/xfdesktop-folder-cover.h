@@ -0,0 +1,49 @@
+/*
+ *  xfdesktop - xfce4's desktop manager
+ *
+ *  Copyright (c) 2014 The Xfce Development Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software Foundation,
+ *  Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __XFDESKTOP_FOLDER_COVER_H__
+#define __XFDESKTOP_FOLDER_COVER_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* cover art for folder icons (Folder.jpg, cover.jpg and friends).  the
+ * result of scanning a folder is remembered, across restarts, for as long
+ * as the folder's mtime stays the same. */
+
+typedef void (*XfdesktopFolderCoverFunc)(GObject *object,
+                                         const gchar *cover_path);
+
+gboolean xfdesktop_folder_cover_lookup(GFile *folder,
+                                       GFileInfo *folder_info,
+                                       gchar **cover_path);
+
+void xfdesktop_folder_cover_scan(GFile *folder,
+                                 GObject *object,
+                                 XfdesktopFolderCoverFunc func);
+
+gboolean xfdesktop_folder_cover_name_is_candidate(const gchar *name);
+
+void xfdesktop_folder_cover_save_cache(void);
+
+G_END_DECLS
+
+#endif  /* __XFDESKTOP_FOLDER_COVER_H__ */
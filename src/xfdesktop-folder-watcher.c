@@ -0,0 +1,398 @@
+/*
+ *  xfdesktop - xfce4's desktop manager
+ *
+ *  Copyright (c) 2014 The Xfce Development Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software Foundation,
+ *  Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gio/gio.h>
+
+#include <libxfce4util/libxfce4util.h>
+
+#include "xfdesktop-folder-cover.h"
+#include "xfdesktop-folder-watcher.h"
+
+/* folders without a monitor are checked this often (in seconds), a few at
+ * a time */
+#define POLL_INTERVAL  30
+#define POLL_BATCH     8
+
+typedef struct
+{
+    XfdesktopFolderWatchFunc func;
+    gpointer user_data;
+} XfdesktopFolderWatchClient;
+
+typedef struct
+{
+    XfdesktopFolderWatcher *watcher;
+    GFile *folder;
+    GList *clients;
+
+    /* set while the folder has a monitor; its link in watcher->active */
+    GFileMonitor *monitor;
+    GList *active_link;
+
+    /* the folder's mtime when it was last looked at, for polling */
+    guint64 mtime;
+    gboolean polling;
+} XfdesktopFolderWatch;
+
+struct _XfdesktopFolderWatcher
+{
+    /* GFile -> XfdesktopFolderWatch */
+    GHashTable *watches;
+    /* watches with a monitor, most recently active first */
+    GQueue active;
+    guint max_monitors;
+
+    /* watches without one, polled round-robin */
+    GQueue evicted;
+    guint poll_id;
+
+    gint64 created;
+    guint n_wakeups;
+    guint n_forwarded;
+    guint n_evictions;
+    guint n_polls;
+};
+
+static void xfdesktop_folder_watcher_activate(XfdesktopFolderWatcher *watcher,
+                                              XfdesktopFolderWatch *watch);
+
+
+static void
+xfdesktop_folder_watch_notify(XfdesktopFolderWatch *watch,
+                              GFile *child,
+                              GFileMonitorEvent event)
+{
+    GList *l, *next;
+
+    for(l = watch->clients; l; l = next) {
+        XfdesktopFolderWatchClient *client = l->data;
+
+        /* a client may remove itself */
+        next = l->next;
+        client->func(watch->folder, child, event, client->user_data);
+    }
+}
+
+static void
+xfdesktop_folder_watch_changed(GFileMonitor *monitor,
+                               GFile *file,
+                               GFile *other_file,
+                               GFileMonitorEvent event,
+                               gpointer user_data)
+{
+    XfdesktopFolderWatch *watch = user_data;
+    XfdesktopFolderWatcher *watcher = watch->watcher;
+    gchar *name;
+
+    watcher->n_wakeups++;
+
+    /* keep busy folders monitored */
+    g_queue_unlink(&watcher->active, watch->active_link);
+    g_queue_push_head_link(&watcher->active, watch->active_link);
+
+    if(event != G_FILE_MONITOR_EVENT_CREATED
+       && event != G_FILE_MONITOR_EVENT_DELETED)
+    {
+        return;
+    }
+
+    /* nobody cares about anything but cover art */
+    name = g_file_get_basename(file);
+    if(name && xfdesktop_folder_cover_name_is_candidate(name)) {
+        watcher->n_forwarded++;
+        xfdesktop_folder_watch_notify(watch, file, event);
+    }
+    g_free(name);
+}
+
+static void
+xfdesktop_folder_watch_stop_monitor(XfdesktopFolderWatch *watch)
+{
+    if(!watch->monitor)
+        return;
+
+    g_signal_handlers_disconnect_by_func(watch->monitor,
+                                         G_CALLBACK(xfdesktop_folder_watch_changed),
+                                         watch);
+    g_file_monitor_cancel(watch->monitor);
+    g_object_unref(watch->monitor);
+    watch->monitor = NULL;
+
+    g_queue_delete_link(&watch->watcher->active, watch->active_link);
+    watch->active_link = NULL;
+}
+
+static void
+xfdesktop_folder_watch_poll_ready(GObject *source,
+                                  GAsyncResult *result,
+                                  gpointer user_data)
+{
+    XfdesktopFolderWatch *watch = user_data;
+    GFileInfo *info;
+    guint64 mtime;
+
+    watch->polling = FALSE;
+
+    info = g_file_query_info_finish(G_FILE(source), result, NULL);
+
+    /* the watch was removed while we were waiting */
+    if(!watch->clients) {
+        if(info)
+            g_object_unref(info);
+        g_object_unref(watch->folder);
+        g_slice_free(XfdesktopFolderWatch, watch);
+        return;
+    }
+
+    if(!info)
+        return;
+
+    mtime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+    g_object_unref(info);
+
+    if(watch->mtime && mtime != watch->mtime) {
+        XfdesktopFolderWatcher *watcher = watch->watcher;
+
+        DBG("polled folder changed, watching it again");
+        watch->mtime = mtime;
+
+        /* it's active now, so it gets a monitor back */
+        g_queue_remove(&watcher->evicted, watch);
+        xfdesktop_folder_watcher_activate(watcher, watch);
+
+        xfdesktop_folder_watch_notify(watch, NULL, G_FILE_MONITOR_EVENT_CHANGED);
+    } else
+        watch->mtime = mtime;
+}
+
+static void
+xfdesktop_folder_watch_poll(XfdesktopFolderWatch *watch)
+{
+    if(watch->polling)
+        return;
+
+    watch->polling = TRUE;
+    watch->watcher->n_polls++;
+    g_file_query_info_async(watch->folder, G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                            G_FILE_QUERY_INFO_NONE, G_PRIORITY_LOW, NULL,
+                            xfdesktop_folder_watch_poll_ready, watch);
+}
+
+static gboolean
+xfdesktop_folder_watcher_poll_timeout(gpointer user_data)
+{
+    XfdesktopFolderWatcher *watcher = user_data;
+    guint i;
+
+    if(g_queue_is_empty(&watcher->evicted)) {
+        watcher->poll_id = 0;
+        return FALSE;
+    }
+
+    for(i = 0; i < POLL_BATCH && i < g_queue_get_length(&watcher->evicted); ++i) {
+        /* round-robin */
+        XfdesktopFolderWatch *watch = g_queue_pop_head(&watcher->evicted);
+        g_queue_push_tail(&watcher->evicted, watch);
+        xfdesktop_folder_watch_poll(watch);
+    }
+
+    return TRUE;
+}
+
+/* takes the monitor away from the least recently active folder */
+static void
+xfdesktop_folder_watcher_evict(XfdesktopFolderWatcher *watcher)
+{
+    XfdesktopFolderWatch *lru = g_queue_peek_tail(&watcher->active);
+
+    if(!lru)
+        return;
+
+    xfdesktop_folder_watch_stop_monitor(lru);
+    g_queue_push_tail(&watcher->evicted, lru);
+    watcher->n_evictions++;
+
+    /* remember what it looked like so polling can tell if it changed */
+    xfdesktop_folder_watch_poll(lru);
+
+    if(!watcher->poll_id) {
+        watcher->poll_id = g_timeout_add_seconds(POLL_INTERVAL,
+                                                 xfdesktop_folder_watcher_poll_timeout,
+                                                 watcher);
+    }
+}
+
+/* gives @watch a monitor, evicting another folder if we're at the limit */
+static void
+xfdesktop_folder_watcher_activate(XfdesktopFolderWatcher *watcher,
+                                  XfdesktopFolderWatch *watch)
+{
+    while(g_queue_get_length(&watcher->active) >= watcher->max_monitors)
+        xfdesktop_folder_watcher_evict(watcher);
+
+    watch->monitor = g_file_monitor_directory(watch->folder, G_FILE_MONITOR_NONE,
+                                              NULL, NULL);
+    if(!watch->monitor)
+        return;
+
+    g_signal_connect(watch->monitor, "changed",
+                     G_CALLBACK(xfdesktop_folder_watch_changed), watch);
+
+    g_queue_push_head(&watcher->active, watch);
+    watch->active_link = watcher->active.head;
+}
+
+static void
+xfdesktop_folder_watch_destroy(XfdesktopFolderWatch *watch)
+{
+    XfdesktopFolderWatcher *watcher = watch->watcher;
+
+    if(watch->monitor)
+        xfdesktop_folder_watch_stop_monitor(watch);
+    else
+        g_queue_remove(&watcher->evicted, watch);
+
+    g_list_foreach(watch->clients, (GFunc)g_free, NULL);
+    g_list_free(watch->clients);
+    watch->clients = NULL;
+
+    /* a running poll frees it when it finishes */
+    if(!watch->polling) {
+        g_object_unref(watch->folder);
+        g_slice_free(XfdesktopFolderWatch, watch);
+    }
+}
+
+
+XfdesktopFolderWatcher *
+xfdesktop_folder_watcher_new(guint max_monitors)
+{
+    XfdesktopFolderWatcher *watcher = g_slice_new0(XfdesktopFolderWatcher);
+
+    watcher->watches = g_hash_table_new_full(g_file_hash,
+                                             (GEqualFunc)g_file_equal,
+                                             NULL,
+                                             (GDestroyNotify)xfdesktop_folder_watch_destroy);
+    g_queue_init(&watcher->active);
+    g_queue_init(&watcher->evicted);
+    watcher->max_monitors = MAX(max_monitors, 1);
+    watcher->created = g_get_monotonic_time();
+
+    return watcher;
+}
+
+void
+xfdesktop_folder_watcher_free(XfdesktopFolderWatcher *watcher)
+{
+    gdouble minutes;
+
+    if(!watcher)
+        return;
+
+    minutes = (g_get_monotonic_time() - watcher->created) / (60.0 * G_USEC_PER_SEC);
+    DBG("folder watches: %u folders, %u monitors, %u wakeups (%.1f/min), "
+        "%u forwarded, %u evictions, %u polls",
+        g_hash_table_size(watcher->watches), g_queue_get_length(&watcher->active),
+        watcher->n_wakeups, minutes > 0 ? watcher->n_wakeups / minutes : 0.0,
+        watcher->n_forwarded, watcher->n_evictions, watcher->n_polls);
+
+    if(watcher->poll_id)
+        g_source_remove(watcher->poll_id);
+
+    g_hash_table_destroy(watcher->watches);
+    g_slice_free(XfdesktopFolderWatcher, watcher);
+}
+
+void
+xfdesktop_folder_watcher_set_max_monitors(XfdesktopFolderWatcher *watcher,
+                                          guint max_monitors)
+{
+    g_return_if_fail(watcher);
+
+    watcher->max_monitors = MAX(max_monitors, 1);
+
+    /* folders over the new limit are polled from now on; if it went up,
+     * evicted folders get their monitors back as they change */
+    while(g_queue_get_length(&watcher->active) > watcher->max_monitors)
+        xfdesktop_folder_watcher_evict(watcher);
+}
+
+/* calls @func whenever cover art in @folder may have changed, until the
+ * same @func and @user_data are passed to xfdesktop_folder_watcher_remove() */
+void
+xfdesktop_folder_watcher_add(XfdesktopFolderWatcher *watcher,
+                             GFile *folder,
+                             XfdesktopFolderWatchFunc func,
+                             gpointer user_data)
+{
+    XfdesktopFolderWatch *watch;
+    XfdesktopFolderWatchClient *client;
+
+    g_return_if_fail(watcher && G_IS_FILE(folder) && func);
+
+    watch = g_hash_table_lookup(watcher->watches, folder);
+    if(!watch) {
+        watch = g_slice_new0(XfdesktopFolderWatch);
+        watch->watcher = watcher;
+        watch->folder = g_object_ref(folder);
+        g_hash_table_insert(watcher->watches, watch->folder, watch);
+
+        xfdesktop_folder_watcher_activate(watcher, watch);
+    }
+
+    client = g_new(XfdesktopFolderWatchClient, 1);
+    client->func = func;
+    client->user_data = user_data;
+    watch->clients = g_list_prepend(watch->clients, client);
+}
+
+void
+xfdesktop_folder_watcher_remove(XfdesktopFolderWatcher *watcher,
+                                GFile *folder,
+                                XfdesktopFolderWatchFunc func,
+                                gpointer user_data)
+{
+    XfdesktopFolderWatch *watch;
+    GList *l;
+
+    g_return_if_fail(watcher && G_IS_FILE(folder));
+
+    watch = g_hash_table_lookup(watcher->watches, folder);
+    if(!watch)
+        return;
+
+    for(l = watch->clients; l; l = l->next) {
+        XfdesktopFolderWatchClient *client = l->data;
+
+        if(client->func == func && client->user_data == user_data) {
+            g_free(client);
+            watch->clients = g_list_delete_link(watch->clients, l);
+            break;
+        }
+    }
+
+    /* last one out */
+    if(!watch->clients)
+        g_hash_table_remove(watcher->watches, folder);
+}
@@ -0,0 +1,58 @@
+/*
+ *  xfdesktop - xfce4's desktop manager
+ *
+ *  Copyright (c) 2014 The Xfce Development Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software Foundation,
+ *  Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __XFDESKTOP_FOLDER_WATCHER_H__
+#define __XFDESKTOP_FOLDER_WATCHER_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* watches the contents of folders shown on the desktop for changes to
+ * their cover art.  every folder gets at most one GFileMonitor no matter
+ * how many icons watch it, and at most a fixed number of monitors exist at
+ * once; the least recently active folders are polled instead. */
+typedef struct _XfdesktopFolderWatcher XfdesktopFolderWatcher;
+
+/* @child is the cover candidate that was created or deleted, or NULL with
+ * G_FILE_MONITOR_EVENT_CHANGED if polling found that something changed */
+typedef void (*XfdesktopFolderWatchFunc)(GFile *folder,
+                                         GFile *child,
+                                         GFileMonitorEvent event,
+                                         gpointer user_data);
+
+XfdesktopFolderWatcher *xfdesktop_folder_watcher_new(guint max_monitors);
+void xfdesktop_folder_watcher_free(XfdesktopFolderWatcher *watcher);
+
+void xfdesktop_folder_watcher_set_max_monitors(XfdesktopFolderWatcher *watcher,
+                                               guint max_monitors);
+
+void xfdesktop_folder_watcher_add(XfdesktopFolderWatcher *watcher,
+                                  GFile *folder,
+                                  XfdesktopFolderWatchFunc func,
+                                  gpointer user_data);
+void xfdesktop_folder_watcher_remove(XfdesktopFolderWatcher *watcher,
+                                     GFile *folder,
+                                     XfdesktopFolderWatchFunc func,
+                                     gpointer user_data);
+
+G_END_DECLS
+
+#endif  /* __XFDESKTOP_FOLDER_WATCHER_H__ */
@@ -0,0 +1,196 @@
+/*
+ *  xfdesktop - xfce4's desktop manager
+ *
+ *  Copyright (c) 2014 The Xfce Development Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software Foundation,
+ *  Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gio/gio.h>
+
+#include <libxfce4util/libxfce4util.h>
+
+#include "xfdesktop-file-utils.h"
+#include "xfdesktop-icon-loader.h"
+
+/* decoding is mostly waiting on the disk; a couple of threads keep it
+ * busy without fighting the main thread for the CPU */
+#define ICON_LOADER_MAX_THREADS  2
+
+struct _XfdesktopIconLoad
+{
+    GIcon *icon;
+    gint width;
+    gint height;
+    GCancellable *cancellable;
+
+    XfdesktopIconLoadFunc func;
+    gpointer user_data;
+
+    GdkPixbuf *pix;
+
+    /* only touched with the loader lock held; the link is set for as long
+     * as no worker has picked the load up */
+    gboolean visible;
+    GList *queue_link;
+};
+
+static GThreadPool *icon_loader_pool = NULL;
+
+/* pending loads, oldest first; a worker takes from the visible queue
+ * before the hidden one */
+G_LOCK_DEFINE_STATIC(icon_loader);
+static GQueue icon_loader_visible = G_QUEUE_INIT;
+static GQueue icon_loader_hidden = G_QUEUE_INIT;
+
+
+static void
+xfdesktop_icon_load_free(XfdesktopIconLoad *load)
+{
+    g_object_unref(load->icon);
+    g_object_unref(load->cancellable);
+    if(load->pix)
+        g_object_unref(load->pix);
+    g_slice_free(XfdesktopIconLoad, load);
+}
+
+static gboolean
+xfdesktop_icon_loader_deliver(gpointer user_data)
+{
+    XfdesktopIconLoad *load = user_data;
+
+    if(!g_cancellable_is_cancelled(load->cancellable))
+        load->func(load->pix, load->user_data);
+
+    xfdesktop_icon_load_free(load);
+
+    return FALSE;
+}
+
+static void
+xfdesktop_icon_loader_worker(gpointer data,
+                             gpointer user_data)
+{
+    XfdesktopIconLoad *load;
+
+    /* every queued load pushes one job into the pool, but the job takes
+     * whichever load is most urgent by now */
+    G_LOCK(icon_loader);
+    load = g_queue_pop_head(&icon_loader_visible);
+    if(!load)
+        load = g_queue_pop_head(&icon_loader_hidden);
+    if(load)
+        load->queue_link = NULL;
+    G_UNLOCK(icon_loader);
+
+    /* its load was cancelled while still queued */
+    if(!load)
+        return;
+
+    if(!g_cancellable_is_cancelled(load->cancellable)) {
+        load->pix = xfdesktop_file_utils_load_loadable_icon(load->icon,
+                                                            load->width,
+                                                            load->height,
+                                                            load->cancellable);
+    }
+
+    g_idle_add(xfdesktop_icon_loader_deliver, load);
+}
+
+
+XfdesktopIconLoad *
+xfdesktop_icon_loader_load(GIcon *icon,
+                           gint width,
+                           gint height,
+                           gboolean visible,
+                           XfdesktopIconLoadFunc func,
+                           gpointer user_data)
+{
+    XfdesktopIconLoad *load;
+    GQueue *queue;
+
+    g_return_val_if_fail(G_IS_LOADABLE_ICON(icon) && func, NULL);
+
+    if(!icon_loader_pool) {
+        icon_loader_pool = g_thread_pool_new(xfdesktop_icon_loader_worker,
+                                             NULL, ICON_LOADER_MAX_THREADS,
+                                             FALSE, NULL);
+    }
+
+    load = g_slice_new0(XfdesktopIconLoad);
+    load->icon = g_object_ref(icon);
+    load->width = width;
+    load->height = height;
+    load->cancellable = g_cancellable_new();
+    load->func = func;
+    load->user_data = user_data;
+    load->visible = visible;
+
+    queue = visible ? &icon_loader_visible : &icon_loader_hidden;
+
+    G_LOCK(icon_loader);
+    g_queue_push_tail(queue, load);
+    load->queue_link = queue->tail;
+    G_UNLOCK(icon_loader);
+
+    g_thread_pool_push(icon_loader_pool, GINT_TO_POINTER(1), NULL);
+
+    return load;
+}
+
+/* the icon turned out to be on screen; load it ahead of the ones that
+ * aren't */
+void
+xfdesktop_icon_loader_set_visible(XfdesktopIconLoad *load)
+{
+    g_return_if_fail(load != NULL);
+
+    G_LOCK(icon_loader);
+    if(load->queue_link && !load->visible) {
+        g_queue_unlink(&icon_loader_hidden, load->queue_link);
+        g_queue_push_tail_link(&icon_loader_visible, load->queue_link);
+        load->visible = TRUE;
+    }
+    G_UNLOCK(icon_loader);
+}
+
+void
+xfdesktop_icon_loader_cancel(XfdesktopIconLoad *load)
+{
+    gboolean queued;
+
+    g_return_if_fail(load != NULL);
+
+    G_LOCK(icon_loader);
+    queued = (load->queue_link != NULL);
+    if(queued) {
+        g_queue_delete_link(load->visible ? &icon_loader_visible : &icon_loader_hidden,
+                            load->queue_link);
+        load->queue_link = NULL;
+    }
+    G_UNLOCK(icon_loader);
+
+    if(queued) {
+        /* no worker will ever see it */
+        xfdesktop_icon_load_free(load);
+    } else {
+        /* a worker has it; it gets dropped once it comes back */
+        g_cancellable_cancel(load->cancellable);
+    }
+}
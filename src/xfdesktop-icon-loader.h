@@ -0,0 +1,54 @@
+/*
+ *  xfdesktop - xfce4's desktop manager
+ *
+ *  Copyright (c) 2014 The Xfce Development Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software Foundation,
+ *  Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __XFDESKTOP_ICON_LOADER_H__
+#define __XFDESKTOP_ICON_LOADER_H__
+
+#include <gio/gio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+/* decodes file and loadable icons (thumbnails, folder covers, images
+ * named by launchers) on a small pool of worker threads, so the first
+ * paint of the desktop doesn't wait on the disk.  loads for icons that
+ * are on screen go first. */
+typedef struct _XfdesktopIconLoad XfdesktopIconLoad;
+
+/* called in the main thread.  @pix is NULL if the icon couldn't be
+ * loaded.  never called for a cancelled load. */
+typedef void (*XfdesktopIconLoadFunc)(GdkPixbuf *pix,
+                                      gpointer user_data);
+
+/* the returned handle is valid until @func is called or the load is
+ * cancelled, whichever comes first */
+XfdesktopIconLoad *xfdesktop_icon_loader_load(GIcon *icon,
+                                              gint width,
+                                              gint height,
+                                              gboolean visible,
+                                              XfdesktopIconLoadFunc func,
+                                              gpointer user_data);
+
+void xfdesktop_icon_loader_set_visible(XfdesktopIconLoad *load);
+void xfdesktop_icon_loader_cancel(XfdesktopIconLoad *load);
+
+G_END_DECLS
+
+#endif  /* __XFDESKTOP_ICON_LOADER_H__ */
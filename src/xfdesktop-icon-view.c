@@ -44,6 +44,7 @@
 #include "xfdesktop-icon-view.h"
 #include "xfdesktop-file-icon-manager.h"
 #include "xfdesktop-marshal.h"
+#include "xfdesktop-pixbuf-utils.h"
 #include "xfce-desktop.h"
 #include "xfdesktop-volume-icon.h"
 #include "xfdesktop-common.h"
@@ -67,6 +68,9 @@
 #define SCREEN_MARGIN     8
 #define DEFAULT_RUBBERBAND_ALPHA  64
 
+/* upper bound on the memory held by pre-rendered icon cells */
+#define CELL_CACHE_MAX_BYTES  (32 * 1024 * 1024)
+
 #if defined(DEBUG) && DEBUG > 0
 #define DUMP_GRID_LAYOUT(icon_view) \
 {\
@@ -103,6 +107,45 @@ typedef struct
     guint source_id;
 } XfdesktopIdleRepaintData;
 
+/* a fully composited icon cell (pixbuf, label box, shadow and label),
+ * covering the icon's total extents */
+typedef struct
+{
+    XfdesktopIcon *icon;
+    cairo_surface_t *surface;
+    GdkPixbuf *pix;
+    GtkStateType state;
+    gboolean prelit;
+    gsize size;
+    GList *lru_link;
+} XfdesktopIconCellCacheEntry;
+
+enum
+{
+    LABEL_VARIANT_FULL = 0,
+    LABEL_VARIANT_TRUNCATED,
+    LABEL_N_VARIANTS,
+};
+
+/* wrapped label layouts and their pixel extents for one icon: the full text
+ * shown when the icon is selected, and the ellipsized text otherwise */
+typedef struct
+{
+    gchar *label;
+    PangoLayout *layout[LABEL_N_VARIANTS];
+    PangoRectangle extents[LABEL_N_VARIANTS];
+} XfdesktopIconLabelMetrics;
+
+/* an icon's pixbuf as drawn in each state: colorized with the selection
+ * colour for SELECTED and ACTIVE, and spotlit when prelit.  variant 0 is
+ * the unmodified source pixbuf. */
+#define STATE_PIXBUF_N_VARIANTS  6
+typedef struct
+{
+    GdkPixbuf *source;
+    GdkPixbuf *variants[STATE_PIXBUF_N_VARIANTS];
+} XfdesktopIconStatePixbufs;
+
 struct _XfdesktopIconViewPrivate
 {
     XfdesktopIconViewManager *manager;
@@ -113,11 +156,21 @@ struct _XfdesktopIconViewPrivate
     gdouble font_size;
     
     WnckScreen *wnck_screen;
+    /* holds the font used for labels; per-icon layouts are copied from it */
     PangoLayout *playout;
+    GHashTable *label_metrics;
+    /* XfdesktopIcon -> XfdesktopIconStatePixbufs */
+    GHashTable *state_pixbufs;
+    /* set of icons whose extents spill out of their grid cell, usually
+     * because of a long, unellipsized label */
+    GHashTable *overflow_icons;
     
     GList *pending_icons;
     GList *icons;
     GList *selected_icons;
+    /* XfdesktopIcon -> its link in selected_icons, so membership tests and
+     * removals don't have to walk the list */
+    GHashTable *selected_set;
     
     gint xorigin;
     gint yorigin;
@@ -127,6 +180,10 @@ struct _XfdesktopIconViewPrivate
     guint16 nrows;
     guint16 ncols;
     XfdesktopIcon **grid_layout;
+    /* one bit per grid_layout cell, in the same order, set if the cell is
+     * free.  every cell before grid_free_cursor is known to be taken. */
+    guint64 *grid_free_map;
+    gint grid_free_cursor;
     
     guint grid_resize_timeout;
     
@@ -138,6 +195,16 @@ struct _XfdesktopIconViewPrivate
     gint press_start_x;
     gint press_start_y;
     GdkRectangle band_rect;
+    /* latest pointer position during a rubber band drag; the band itself
+     * is only updated from an idle, once per redraw */
+    gint band_x;
+    gint band_y;
+    guint band_update_id;
+
+    /* while a batch of insertions is in progress, the cells they touch are
+     * collected here and painted together when the batch ends */
+    GdkRegion *batch_damage;
+    guint batch_depth;
 
     XfconfChannel *channel;
 
@@ -188,6 +255,14 @@ struct _XfdesktopIconViewPrivate
     double tooltip_szie_from_xfconf;
 
     gboolean single_click;
+
+    /* XfdesktopIcon -> XfdesktopIconCellCacheEntry; most recently used
+     * entries are at the head of cell_cache_lru */
+    GHashTable *cell_cache;
+    GQueue cell_cache_lru;
+    gsize cell_cache_size;
+    guint cell_cache_hits;
+    guint cell_cache_misses;
 };
 
 static void xfce_icon_view_set_property(GObject *object,
@@ -217,6 +292,7 @@ static gboolean xfdesktop_icon_view_focus_out(GtkWidget *widget,
 static gboolean xfdesktop_icon_view_motion_notify(GtkWidget *widget,
                                                   GdkEventMotion *evt,
                                                   gpointer user_data);
+static void xfdesktop_icon_view_update_rubber_band(XfdesktopIconView *icon_view);
 static gboolean xfdesktop_icon_view_leave_notify(GtkWidget *widget,
                                                  GdkEventCrossing *evt,
                                                  gpointer user_data);
@@ -255,6 +331,7 @@ static void xfdesktop_icon_view_drag_data_received(GtkWidget *widget,
                                                    guint time_);
                                                       
 static void xfdesktop_icon_view_finalize(GObject *obj);
+static void xfdesktop_icon_view_cell_cache_entry_free(gpointer data);
 
 static void xfdesktop_icon_view_add_move_binding(GtkBindingSet *binding_set,
                                                  guint keyval,
@@ -280,10 +357,17 @@ static void xfdesktop_icon_view_invalidate_icon_pixbuf(XfdesktopIconView *icon_v
 static void xfdesktop_icon_view_paint_icon(XfdesktopIconView *icon_view,
                                            XfdesktopIcon *icon,
                                            GdkRectangle *area);
+static void xfdesktop_icon_view_cell_cache_remove(XfdesktopIconView *icon_view,
+                                                  XfdesktopIcon *icon);
+static void xfdesktop_icon_view_cell_cache_flush(XfdesktopIconView *icon_view);
+static void xfdesktop_icon_view_label_metrics_free(gpointer data);
+static void xfdesktop_icon_view_label_metrics_flush(XfdesktopIconView *icon_view);
+static void xfdesktop_icon_view_state_pixbufs_free(gpointer data);
 static void xfdesktop_icon_view_repaint_icons(XfdesktopIconView *icon_view,
                                               GdkRectangle *area);
                                   
 static void xfdesktop_setup_grids(XfdesktopIconView *icon_view);
+static void xfdesktop_grid_reset_free_map(XfdesktopIconView *icon_view);
 static gboolean xfdesktop_grid_get_next_free_position(XfdesktopIconView *icon_view,
                                                       guint16 *row,
                                                       guint16 *col);
@@ -306,9 +390,14 @@ static inline XfdesktopIcon *xfdesktop_icon_view_icon_in_cell(XfdesktopIconView
                                                               guint16 col);
 static gint xfdesktop_check_icon_clicked(gconstpointer data,
                                          gconstpointer user_data);
-static void xfdesktop_list_foreach_invalidate(gpointer data,
-                                              gpointer user_data);
 
+static gboolean xfdesktop_icon_view_rect_to_cells(XfdesktopIconView *icon_view,
+                                                  GdkRectangle *rect,
+                                                  gboolean whole_cells_only,
+                                                  gint *first_row,
+                                                  gint *last_row,
+                                                  gint *first_col,
+                                                  gint *last_col);
 static inline void xfdesktop_xy_to_rowcol(XfdesktopIconView *icon_view,
                                           gint x,
                                           gint y,
@@ -345,6 +434,16 @@ static gboolean xfdesktop_icon_view_show_tooltip(GtkWidget *widget,
 
 static gboolean xfdesktop_icon_view_is_icon_selected(XfdesktopIconView *icon_view,
                                                      XfdesktopIcon *icon);
+static gboolean xfdesktop_icon_view_selection_add(XfdesktopIconView *icon_view,
+                                                  XfdesktopIcon *icon);
+static gboolean xfdesktop_icon_view_selection_remove(XfdesktopIconView *icon_view,
+                                                     XfdesktopIcon *icon);
+static void xfdesktop_icon_view_selection_clear(XfdesktopIconView *icon_view);
+static void xfdesktop_icon_view_damage_icon(XfdesktopIconView *icon_view,
+                                            XfdesktopIcon *icon,
+                                            GdkRegion *damage);
+static void xfdesktop_icon_view_selection_changed(XfdesktopIconView *icon_view,
+                                                  GdkRegion *damage);
 static void xfdesktop_icon_view_real_select_all(XfdesktopIconView *icon_view);
 static void xfdesktop_icon_view_real_unselect_all(XfdesktopIconView *icon_view);
 static void xfdesktop_icon_view_real_select_cursor_item(XfdesktopIconView *icon_view);
@@ -357,9 +456,6 @@ static gboolean xfdesktop_icon_view_real_move_cursor(XfdesktopIconView *icon_vie
 static void xfdesktop_icon_view_move_cursor_left_right(XfdesktopIconView *icon_view,
                                                        gint count,
                                                        GdkModifierType modmask);
-static void xfdesktop_icon_view_select_between(XfdesktopIconView *icon_view,
-                                               XfdesktopIcon *start_icon,
-                                               XfdesktopIcon *end_icon);
 
 enum
 {
@@ -694,6 +790,28 @@ xfdesktop_icon_view_init(XfdesktopIconView *icon_view)
 
     icon_view->priv->allow_rubber_banding = TRUE;
     icon_view->priv->selection_box_alpha = DEFAULT_RUBBERBAND_ALPHA;
+
+    icon_view->priv->cell_cache = g_hash_table_new_full(g_direct_hash,
+                                                        g_direct_equal,
+                                                        NULL,
+                                                        xfdesktop_icon_view_cell_cache_entry_free);
+    g_queue_init(&icon_view->priv->cell_cache_lru);
+
+    icon_view->priv->label_metrics = g_hash_table_new_full(g_direct_hash,
+                                                           g_direct_equal,
+                                                           NULL,
+                                                           xfdesktop_icon_view_label_metrics_free);
+
+    icon_view->priv->state_pixbufs = g_hash_table_new_full(g_direct_hash,
+                                                           g_direct_equal,
+                                                           NULL,
+                                                           xfdesktop_icon_view_state_pixbufs_free);
+
+    icon_view->priv->overflow_icons = g_hash_table_new(g_direct_hash,
+                                                       g_direct_equal);
+
+    icon_view->priv->selected_set = g_hash_table_new(g_direct_hash,
+                                                     g_direct_equal);
     
     icon_view->priv->native_targets = gtk_target_list_new(icon_view_targets,
                                                           icon_view_n_targets);
@@ -732,6 +850,14 @@ xfdesktop_icon_view_finalize(GObject *obj)
     g_list_free(icon_view->priv->pending_icons);
     /* icon_view->priv->icons should be cleared in _unrealize() */
 
+    xfdesktop_icon_view_cell_cache_flush(icon_view);
+    g_hash_table_destroy(icon_view->priv->cell_cache);
+    g_hash_table_destroy(icon_view->priv->label_metrics);
+    g_hash_table_destroy(icon_view->priv->state_pixbufs);
+    g_hash_table_destroy(icon_view->priv->overflow_icons);
+    g_list_free(icon_view->priv->selected_icons);
+    g_hash_table_destroy(icon_view->priv->selected_set);
+
     if (icon_view->priv->channel)
         icon_view->priv->channel = NULL;
 
@@ -886,9 +1012,9 @@ xfdesktop_icon_view_button_press(GtkWidget *widget,
                    && icon_view->priv->first_clicked_item
                    && icon_view->priv->first_clicked_item != icon)
                 {
-                    xfdesktop_icon_view_select_between(icon_view,
-                                                       icon_view->priv->first_clicked_item,
-                                                       icon);
+                    xfdesktop_icon_view_select_range(icon_view,
+                                                     icon_view->priv->first_clicked_item,
+                                                     icon);
                 } else
                     xfdesktop_icon_view_select_item(icon_view, icon);
             }
@@ -1039,6 +1165,12 @@ xfdesktop_icon_view_button_release(GtkWidget *widget,
         DBG("unsetting stuff");
         icon_view->priv->definitely_dragging = FALSE;
         icon_view->priv->maybe_begin_drag = FALSE;
+        if(icon_view->priv->band_update_id) {
+            /* apply the last pointer position before the band goes away */
+            g_source_remove(icon_view->priv->band_update_id);
+            icon_view->priv->band_update_id = 0;
+            xfdesktop_icon_view_update_rubber_band(icon_view);
+        }
         if(icon_view->priv->definitely_rubber_banding) {
             /* Remove the rubber band selection box */
             icon_view->priv->definitely_rubber_banding = FALSE;
@@ -1189,6 +1321,160 @@ xfdesktop_icon_view_show_tooltip(GtkWidget *widget,
     return TRUE;
 }
 
+/* selects @icon if it just came inside the rubber band, and unselects it if
+ * it just left.  only icons the band used to cover are unselected, so that
+ * CTRL + rubber band works properly (Bug 10275). */
+static gboolean
+xfdesktop_icon_view_rubber_band_update_icon(XfdesktopIconView *icon_view,
+                                            XfdesktopIcon *icon,
+                                            GdkRectangle *old_rect,
+                                            GdkRectangle *new_rect,
+                                            GdkRegion *damage)
+{
+    GdkRectangle extents, dummy;
+    gboolean in_old, in_new;
+
+    if(!xfdesktop_icon_get_extents(icon, NULL, NULL, &extents))
+        return FALSE;
+
+    in_old = gdk_rectangle_intersect(&extents, old_rect, &dummy);
+    in_new = gdk_rectangle_intersect(&extents, new_rect, &dummy);
+
+    if(in_new && !in_old) {
+        if(xfdesktop_icon_view_selection_add(icon_view, icon)) {
+            xfdesktop_icon_view_damage_icon(icon_view, icon, damage);
+            xfdesktop_icon_selected(icon);
+            return TRUE;
+        }
+    } else if(in_old && !in_new) {
+        if(xfdesktop_icon_view_selection_remove(icon_view, icon)) {
+            xfdesktop_icon_view_damage_icon(icon_view, icon, damage);
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+static void
+xfdesktop_icon_view_update_rubber_band(XfdesktopIconView *icon_view)
+{
+    GtkWidget *widget = GTK_WIDGET(icon_view);
+    GdkRectangle old_rect, *new_rect, intersect, bounds;
+    GdkRegion *region, *damage;
+    gint first_row, last_row, first_col, last_col;
+    gint in_first_row = 0, in_last_row = -1, in_first_col = 0, in_last_col = -1;
+    gint row, col;
+    GList *overflow;
+    gboolean changed = FALSE;
+
+    new_rect = &icon_view->priv->band_rect;
+    old_rect = *new_rect;
+
+    new_rect->x = MIN(icon_view->priv->press_start_x, icon_view->priv->band_x);
+    new_rect->y = MIN(icon_view->priv->press_start_y, icon_view->priv->band_y);
+    new_rect->width = ABS(icon_view->priv->band_x - icon_view->priv->press_start_x) + 1;
+    new_rect->height = ABS(icon_view->priv->band_y - icon_view->priv->press_start_y) + 1;
+
+    region = gdk_region_rectangle(&old_rect);
+    gdk_region_union_with_rect(region, new_rect);
+
+    if(gdk_rectangle_intersect(&old_rect, new_rect, &intersect)
+       && intersect.width > 2 && intersect.height > 2)
+    {
+        GdkRegion *region_intersect;
+        GdkRectangle inner = intersect;
+
+        /* invalidate border too */
+        inner.x += 1;
+        inner.width -= 2;
+        inner.y += 1;
+        inner.height -= 2;
+
+        region_intersect = gdk_region_rectangle(&inner);
+        gdk_region_subtract(region, region_intersect);
+        gdk_region_destroy(region_intersect);
+    }
+
+    gdk_window_invalidate_region(gtk_widget_get_window(widget), region, TRUE);
+    gdk_region_destroy(region);
+
+    /* update list of selected icons.  an icon can only change state if
+     * the edge of the band moved across it, so skip the cells that lie
+     * entirely within both the old and the new band */
+    if(gdk_rectangle_intersect(&old_rect, new_rect, &intersect)
+       && !xfdesktop_icon_view_rect_to_cells(icon_view, &intersect, TRUE,
+                                             &in_first_row, &in_last_row,
+                                             &in_first_col, &in_last_col))
+    {
+        in_last_row = in_last_col = -1;
+    }
+
+    damage = gdk_region_new();
+
+    gdk_rectangle_union(&old_rect, new_rect, &bounds);
+    if(xfdesktop_icon_view_rect_to_cells(icon_view, &bounds, FALSE,
+                                         &first_row, &last_row,
+                                         &first_col, &last_col))
+    {
+        for(col = first_col; col <= last_col; ++col) {
+            gboolean skip_col = (col >= in_first_col && col <= in_last_col);
+
+            for(row = first_row; row <= last_row; ++row) {
+                XfdesktopIcon *icon;
+
+                if(skip_col && row == in_first_row && in_first_row <= in_last_row) {
+                    row = in_last_row;
+                    continue;
+                }
+
+                icon = xfdesktop_icon_view_icon_in_cell_raw(icon_view,
+                                                            col * icon_view->priv->nrows + row);
+                if(icon
+                   && xfdesktop_icon_view_rubber_band_update_icon(icon_view, icon,
+                                                                  &old_rect,
+                                                                  new_rect,
+                                                                  damage))
+                {
+                    changed = TRUE;
+                }
+            }
+        }
+    }
+
+    /* icons that draw outside their cell may have been skipped above;
+     * looking at one twice does no harm.  (un)selecting one changes its
+     * extents, which can move it in or out of overflow_icons, so walk a
+     * copy of it */
+    overflow = g_hash_table_get_keys(icon_view->priv->overflow_icons);
+    for(; overflow; overflow = g_list_delete_link(overflow, overflow)) {
+        if(xfdesktop_icon_view_rubber_band_update_icon(icon_view, overflow->data,
+                                                       &old_rect, new_rect,
+                                                       damage))
+        {
+            changed = TRUE;
+        }
+    }
+
+    if(changed)
+        xfdesktop_icon_view_selection_changed(icon_view, damage);
+    else
+        gdk_region_destroy(damage);
+}
+
+static gboolean
+xfdesktop_icon_view_rubber_band_idled(gpointer user_data)
+{
+    XfdesktopIconView *icon_view = XFDESKTOP_ICON_VIEW(user_data);
+
+    icon_view->priv->band_update_id = 0;
+
+    if(icon_view->priv->definitely_rubber_banding)
+        xfdesktop_icon_view_update_rubber_band(icon_view);
+
+    return FALSE;
+}
+
 static gboolean
 xfdesktop_icon_view_motion_notify(GtkWidget *widget,
                                   GdkEventMotion *evt,
@@ -1211,96 +1497,27 @@ xfdesktop_icon_view_motion_notify(GtkWidget *widget,
                    && !icon_view->priv->definitely_rubber_banding)
                   || icon_view->priv->definitely_rubber_banding))
     {
-        GdkRectangle old_rect, *new_rect, intersect;
-        GdkRegion *region;
-        GList *l;
-
         /* we're dragging with no icon under the cursor -> rubber band start
          * OR, we're already doin' the band -> update it */
 
-        new_rect = &icon_view->priv->band_rect;
-
         if(!icon_view->priv->definitely_rubber_banding) {
             icon_view->priv->definitely_rubber_banding = TRUE;
-            old_rect.x = icon_view->priv->press_start_x;
-            old_rect.y = icon_view->priv->press_start_y;
-            old_rect.width = old_rect.height = 1;
-        } else
-            memcpy(&old_rect, new_rect, sizeof(old_rect));
-
-        new_rect->x = MIN(icon_view->priv->press_start_x, evt->x);
-        new_rect->y = MIN(icon_view->priv->press_start_y, evt->y);
-        new_rect->width = ABS(evt->x - icon_view->priv->press_start_x) + 1;
-        new_rect->height = ABS(evt->y - icon_view->priv->press_start_y) + 1;
-
-        region = gdk_region_rectangle(&old_rect);
-        gdk_region_union_with_rect(region, new_rect);
-
-        if(gdk_rectangle_intersect(&old_rect, new_rect, &intersect)
-           && intersect.width > 2 && intersect.height > 2)
-        {
-            GdkRegion *region_intersect;
-
-            /* invalidate border too */
-            intersect.x += 1;
-            intersect.width -= 2;
-            intersect.y += 1;
-            intersect.height -= 2;
-
-            region_intersect = gdk_region_rectangle(&intersect);
-            gdk_region_subtract(region, region_intersect);
-            gdk_region_destroy(region_intersect);
-        }
-
-        gdk_window_invalidate_region(gtk_widget_get_window(widget), region, TRUE);
-        gdk_region_destroy(region);
-
-        /* update list of selected icons */
-
-        /* first pass: if the rubber band area got smaller at least in
-         * one dimension, we can try first to just remove icons that
-         * aren't in the band anymore */
-        if(old_rect.width > new_rect->width
-           || old_rect.height > new_rect->height)
-        {
-            l = icon_view->priv->selected_icons;
-            while(l) {
-                GdkRectangle extents, dummy;
-                XfdesktopIcon *icon = l->data;
-
-                /* To be removed, it must intersect the old rectangle and
-                 * not intersect the new one. This way CTRL + rubber band
-                 * works properly (Bug 10275) */
-                if(xfdesktop_icon_get_extents(icon, NULL, NULL, &extents)
-                   && gdk_rectangle_intersect(&extents, &old_rect, NULL)
-                   && !gdk_rectangle_intersect(&extents, new_rect, &dummy))
-                {
-                    /* remove the icon from the selected list */
-                    l = l->next;
-                    xfdesktop_icon_view_unselect_item(icon_view, icon);
-                } else
-                    l = l->next;
-            }
+            icon_view->priv->band_rect.x = icon_view->priv->press_start_x;
+            icon_view->priv->band_rect.y = icon_view->priv->press_start_y;
+            icon_view->priv->band_rect.width = 0;
+            icon_view->priv->band_rect.height = 0;
         }
 
-        /* second pass: if at least one dimension got larger, unfortunately
-         * we have to figure out what icons to add to the selected list */
-        if(old_rect.width < new_rect->width
-           || old_rect.height < new_rect->height)
-        {
-            for(l = icon_view->priv->icons; l; l = l->next) {
-                GdkRectangle extents, dummy;
-                XfdesktopIcon *icon = l->data;
+        icon_view->priv->band_x = evt->x;
+        icon_view->priv->band_y = evt->y;
 
-                if(xfdesktop_icon_get_extents(icon, NULL, NULL, &extents)
-                   && gdk_rectangle_intersect(&extents, new_rect, &dummy)
-                   && !xfdesktop_icon_view_is_icon_selected(icon_view, icon))
-                {
-                    /* since _select_item() prepends to the list, we
-                     * should be ok just calling this */
-                    xfdesktop_icon_view_select_item(icon_view, icon);
-                }
-            }
+        /* run after any other queued motion events, but before the redraw,
+         * so the band is updated at most once per frame */
+        if(!icon_view->priv->band_update_id) {
+            icon_view->priv->band_update_id = g_idle_add_full(GDK_PRIORITY_REDRAW - 1,
+                                                              xfdesktop_icon_view_rubber_band_idled,
+                                                              icon_view,
+                                                              NULL);
         }
     } else {
         XfdesktopIcon *icon;
@@ -1401,6 +1618,41 @@ xfdesktop_xy_to_rowcol(XfdesktopIconView *icon_view,
     *col = (x - icon_view->priv->xorigin - SCREEN_MARGIN) / CELL_SIZE;
 }
 
+/* finds the inclusive range of grid cells that @rect (in widget
+ * coordinates) touches, or, if @whole_cells_only is set, that lie entirely
+ * inside it.  returns FALSE if there are none. */
+static gboolean
+xfdesktop_icon_view_rect_to_cells(XfdesktopIconView *icon_view,
+                                  GdkRectangle *rect,
+                                  gboolean whole_cells_only,
+                                  gint *first_row,
+                                  gint *last_row,
+                                  gint *first_col,
+                                  gint *last_col)
+{
+    gdouble x = rect->x - icon_view->priv->xorigin - SCREEN_MARGIN;
+    gdouble y = rect->y - icon_view->priv->yorigin - SCREEN_MARGIN;
+
+    if(whole_cells_only) {
+        *first_row = ceil(y / CELL_SIZE);
+        *last_row = floor((y + rect->height) / CELL_SIZE) - 1;
+        *first_col = ceil(x / CELL_SIZE);
+        *last_col = floor((x + rect->width) / CELL_SIZE) - 1;
+    } else {
+        *first_row = floor(y / CELL_SIZE);
+        *last_row = floor((y + rect->height - 1) / CELL_SIZE);
+        *first_col = floor(x / CELL_SIZE);
+        *last_col = floor((x + rect->width - 1) / CELL_SIZE);
+    }
+
+    *first_row = MAX(*first_row, 0);
+    *first_col = MAX(*first_col, 0);
+    *last_row = MIN(*last_row, icon_view->priv->nrows - 1);
+    *last_col = MIN(*last_col, icon_view->priv->ncols - 1);
+
+    return *first_row <= *last_row && *first_col <= *last_col;
+}
+
 static inline void
 xfdesktop_icon_view_clear_drag_highlight(XfdesktopIconView *icon_view,
                                          GdkDragContext *context)
@@ -1892,6 +2144,8 @@ static void
 xfdesktop_icon_view_icon_theme_changed(GtkIconTheme *icon_theme,
                                        gpointer user_data)
 {
+    xfdesktop_icon_view_cell_cache_flush(XFDESKTOP_ICON_VIEW(user_data));
+    g_hash_table_remove_all(XFDESKTOP_ICON_VIEW(user_data)->priv->state_pixbufs);
     gtk_widget_queue_draw(GTK_WIDGET(user_data));
 }    
 
@@ -1991,6 +2245,11 @@ xfdesktop_icon_view_style_set(GtkWidget *widget,
     GTK_WIDGET_CLASS(xfdesktop_icon_view_parent_class)->style_set(widget,
                                                                   previous_style);
 
+    /* colors, offsets and label metrics may all have changed */
+    xfdesktop_icon_view_cell_cache_flush(icon_view);
+    xfdesktop_icon_view_label_metrics_flush(icon_view);
+    g_hash_table_remove_all(icon_view->priv->state_pixbufs);
+
     /* do this after we're sure we have a style set */
     if(!icon_view->priv->selection_box_color) {
         GtkStyle *style = gtk_widget_get_style(widget);
@@ -2119,20 +2378,34 @@ xfdesktop_icon_view_unrealize(GtkWidget *widget)
         g_source_remove(icon_view->priv->grid_resize_timeout);
         icon_view->priv->grid_resize_timeout = 0;
     }
+
+    if(icon_view->priv->band_update_id) {
+        g_source_remove(icon_view->priv->band_update_id);
+        icon_view->priv->band_update_id = 0;
+    }
     
     g_signal_handlers_disconnect_by_func(G_OBJECT(gscreen),
                                          G_CALLBACK(xfdesktop_screen_size_changed_cb),
                                          icon_view);
     
     /* FIXME: really clear these? */
-    g_list_free(icon_view->priv->selected_icons);
-    icon_view->priv->selected_icons = NULL;
+    xfdesktop_icon_view_selection_clear(icon_view);
 
     xfdesktop_move_all_icons_to_pending_icons_list(icon_view);
 
     g_free(icon_view->priv->grid_layout);
     icon_view->priv->grid_layout = NULL;
+    g_free(icon_view->priv->grid_free_map);
+    icon_view->priv->grid_free_map = NULL;
     
+    DBG("cell cache: %u hits, %u misses, %lu bytes resident",
+        icon_view->priv->cell_cache_hits, icon_view->priv->cell_cache_misses,
+        (gulong)icon_view->priv->cell_cache_size);
+    xfdesktop_icon_view_cell_cache_flush(icon_view);
+    xfdesktop_icon_view_label_metrics_flush(icon_view);
+    g_hash_table_remove_all(icon_view->priv->state_pixbufs);
+    g_hash_table_remove_all(icon_view->priv->overflow_icons);
+
     g_object_unref(G_OBJECT(icon_view->priv->playout));
     icon_view->priv->playout = NULL;
     
@@ -2161,7 +2434,6 @@ xfdesktop_icon_view_expose(GtkWidget *widget,
 {
     XfdesktopIconView *icon_view = XFDESKTOP_ICON_VIEW(widget);
     GdkRectangle *rects = NULL;
-    GdkRectangle clipbox;
     gint n_rects = 0, i;
 
     /*TRACE("entering");*/
@@ -2170,9 +2442,9 @@ xfdesktop_icon_view_expose(GtkWidget *widget,
         return FALSE;
 
     gdk_region_get_rectangles(evt->region, &rects, &n_rects);
-    gdk_region_get_clipbox(evt->region, &clipbox);
 
-    xfdesktop_icon_view_repaint_icons(icon_view, &clipbox);
+    for(i = 0; i < n_rects; ++i)
+        xfdesktop_icon_view_repaint_icons(icon_view, &rects[i]);
 
     if(icon_view->priv->definitely_rubber_banding) {
         GdkRectangle intersect;
@@ -2258,7 +2530,7 @@ xfdesktop_icon_view_real_toggle_cursor_item(XfdesktopIconView *icon_view)
     if(!icon_view->priv->cursor)
         return;
 
-    if(g_list_find(icon_view->priv->selected_icons, icon_view->priv->cursor))
+    if(xfdesktop_icon_view_is_icon_selected(icon_view, icon_view->priv->cursor))
         xfdesktop_icon_view_unselect_item(icon_view, icon_view->priv->cursor);
     else
         xfdesktop_icon_view_select_item(icon_view, icon_view->priv->cursor);
@@ -2280,42 +2552,6 @@ xfdesktop_icon_view_real_activate_cursor_item(XfdesktopIconView *icon_view)
     return TRUE;
 }
 
-static void
-xfdesktop_icon_view_select_between(XfdesktopIconView *icon_view,
-                                   XfdesktopIcon *start_icon,
-                                   XfdesktopIcon *end_icon)
-{
-    guint16 start_row, start_col, end_row, end_col;
-    gint i, j;
-    XfdesktopIcon *icon;
-
-    if(xfdesktop_icon_get_position(start_icon, &start_row, &start_col)
-       && xfdesktop_icon_get_position(end_icon, &end_row, &end_col))
-    {
-        if(start_row > end_row || (start_row == end_row && start_col > end_col)) {
-            /* flip start and end */
-            guint16 tmpr = start_row, tmpc = start_col;
-
-            start_row = end_row;
-            start_col = end_col;
-            end_row = tmpr;
-            end_col = tmpc;
-        }
-
-        for(i = start_row; i <= end_row; ++i) {
-            for(j = (i == start_row ? start_col : 0);
-                (i == end_row ? j <= end_col : j < icon_view->priv->ncols);
-                ++j)
-            {
-                icon = xfdesktop_icon_view_icon_in_cell(icon_view, i, j);
-                if(icon) {
-                    xfdesktop_icon_view_select_item(icon_view, icon);
-                }
-            }
-        }
-    }
-}
-
 static XfdesktopIcon *
 xfdesktop_icon_view_find_first_icon(XfdesktopIconView *icon_view)
 {
@@ -2506,7 +2742,7 @@ xfdesktop_icon_view_move_cursor_begin_end(XfdesktopIconView *icon_view,
     } else if(old_cursor) {
         if(modmask & GDK_SHIFT_MASK) {
             /* select everything between the cursor and the old_cursor */
-            xfdesktop_icon_view_select_between(icon_view, old_cursor, icon);
+            xfdesktop_icon_view_select_range(icon_view, old_cursor, icon);
         } else if(modmask & GDK_CONTROL_MASK) {
             /* add the icon to the selection */
             xfdesktop_icon_view_select_item(icon_view, icon);
@@ -2569,38 +2805,86 @@ xfdesktop_screen_size_changed_cb(GdkScreen *gscreen,
                                                          icon_view);   
 }
 
+static inline gboolean
+xfdesktop_icon_view_icon_needs_paint(XfdesktopIcon *icon,
+                                     GdkRectangle *area)
+{
+    GdkRectangle extents, dummy;
+
+    return (!xfdesktop_icon_get_extents(icon, NULL, NULL, &extents)
+            || gdk_rectangle_intersect(area, &extents, &dummy));
+}
+
+/* paints the icons touching @area, which should be one of the rectangles
+ * of the expose region.  only the grid cells under @area are looked at,
+ * plus the few icons known to overflow their own cell. */
 static void
 xfdesktop_icon_view_repaint_icons(XfdesktopIconView *icon_view,
                                   GdkRectangle *area)
 {
-    GdkRectangle extents, dummy;
-    GList *l;
+    gint row, col, first_row, last_row, first_col, last_col, nrows;
+    GPtrArray *icons;
+    GHashTableIter iter;
+    gpointer key;
     XfdesktopIcon *icon;
-    
-    /* fist paint non-selected items, then paint selected items */
-    for(l = icon_view->priv->icons; l; l = l->next) {
-        icon = (XfdesktopIcon *)l->data;
-        if (xfdesktop_icon_view_is_icon_selected(icon_view, icon))
-            continue;
+    guint i;
+    gint pass;
 
-        if(!xfdesktop_icon_get_extents(icon, NULL, NULL, &extents)
-           || gdk_rectangle_intersect(area, &extents, &dummy))
-        {
-            xfdesktop_icon_view_paint_icon(icon_view, icon, area);
+    if(!icon_view->priv->grid_layout)
+        return;
+
+    nrows = icon_view->priv->nrows;
+    if(!xfdesktop_icon_view_rect_to_cells(icon_view, area, FALSE,
+                                          &first_row, &last_row,
+                                          &first_col, &last_col))
+    {
+        /* nothing but overflowing icons can be under @area */
+        first_row = first_col = 0;
+        last_row = last_col = -1;
+    }
+
+    icons = g_ptr_array_new();
+
+    for(col = first_col; col <= last_col; ++col) {
+        for(row = first_row; row <= last_row; ++row) {
+            icon = xfdesktop_icon_view_icon_in_cell_raw(icon_view,
+                                                        col * nrows + row);
+            if(icon && xfdesktop_icon_view_icon_needs_paint(icon, area))
+                g_ptr_array_add(icons, icon);
         }
     }
-    
-    for(l = icon_view->priv->icons; l; l = l->next) {
-        icon = (XfdesktopIcon *)l->data;
-        if (!xfdesktop_icon_view_is_icon_selected(icon_view, icon))
+
+    g_hash_table_iter_init(&iter, icon_view->priv->overflow_icons);
+    while(g_hash_table_iter_next(&iter, &key, NULL)) {
+        guint16 irow, icol;
+
+        icon = key;
+        if(!xfdesktop_icon_get_position(icon, &irow, &icol))
             continue;
 
-        if(!xfdesktop_icon_get_extents(icon, NULL, NULL, &extents)
-           || gdk_rectangle_intersect(area, &extents, &dummy))
+        /* already picked up from the grid */
+        if(irow >= first_row && irow <= last_row
+           && icol >= first_col && icol <= last_col)
         {
+            continue;
+        }
+
+        if(xfdesktop_icon_view_icon_needs_paint(icon, area))
+            g_ptr_array_add(icons, icon);
+    }
+
+    /* first paint non-selected items, then paint selected items */
+    for(pass = 0; pass < 2; ++pass) {
+        for(i = 0; i < icons->len; ++i) {
+            icon = g_ptr_array_index(icons, i);
+            if((xfdesktop_icon_view_is_icon_selected(icon_view, icon) ? 1 : 0) != pass)
+                continue;
+
             xfdesktop_icon_view_paint_icon(icon_view, icon, area);
         }
     }
+
+    g_ptr_array_free(icons, TRUE);
 }
 
 static inline gboolean
@@ -2726,6 +3010,8 @@ xfdesktop_setup_grids(XfdesktopIconView *icon_view)
     
     DBG("created grid_layout with %lu positions", (gulong)(new_size/sizeof(gpointer)));
     DUMP_GRID_LAYOUT(icon_view);
+
+    xfdesktop_grid_reset_free_map(icon_view);
     
     xfdesktop_icon_view_setup_grids_xinerama(icon_view);
 }
@@ -2828,68 +3114,62 @@ xfdesktop_icon_view_invalidate_icon_pixbuf(XfdesktopIconView *icon_view,
 
 static void
 xfdesktop_paint_rounded_box(XfdesktopIconView *icon_view,
+                            cairo_t *cr,
                             GtkStateType state,
-                            GdkRectangle *text_area,
-                            GdkRectangle *expose_area)
+                            GdkRectangle *text_area)
 {
-    GdkRectangle box_area, intersection;
-    
+    GdkRectangle box_area;
+    GtkStyle *style = gtk_widget_get_style(GTK_WIDGET(icon_view));
+    double alpha;
+
     box_area = *text_area;
     box_area.x -= LABEL_RADIUS;
     box_area.y -= LABEL_RADIUS;
     box_area.width += LABEL_RADIUS * 2;
     box_area.height += LABEL_RADIUS * 2;
-    
-    if(gdk_rectangle_intersect(&box_area, expose_area, &intersection)) {
-        cairo_t *cr = gdk_cairo_create(gtk_widget_get_window(GTK_WIDGET(icon_view)));
-        GtkStyle *style = gtk_widget_get_style(GTK_WIDGET(icon_view));
-        double alpha;
 
-        if(state == GTK_STATE_NORMAL)
-            alpha = icon_view->priv->label_alpha / 255.;
-        else
-            alpha = icon_view->priv->selected_label_alpha / 255.;
-
-        cairo_set_source_rgba(cr, style->base[state].red / 65535.,
-                              style->base[state].green / 65535.,
-                              style->base[state].blue / 65535.,
-                              alpha);
+    if(state == GTK_STATE_NORMAL)
+        alpha = icon_view->priv->label_alpha / 255.;
+    else
+        alpha = icon_view->priv->selected_label_alpha / 255.;
 
-        /* restrict painting to expose area */
-        gdk_cairo_rectangle(cr, expose_area);
-        cairo_clip(cr);
+    cairo_save(cr);
 
-        if(LABEL_RADIUS < 0.1)
-            gdk_cairo_rectangle(cr, &box_area);
-        else {
-            cairo_move_to(cr, box_area.x, box_area.y + LABEL_RADIUS);
-            cairo_arc(cr, box_area.x + LABEL_RADIUS,
-                      box_area.y + LABEL_RADIUS, LABEL_RADIUS,
-                      M_PI, 3.0*M_PI/2.0);
-            cairo_line_to(cr, box_area.x + box_area.width - LABEL_RADIUS,
-                          box_area.y);
-            cairo_arc(cr, box_area.x + box_area.width - LABEL_RADIUS,
-                      box_area.y + LABEL_RADIUS, LABEL_RADIUS,
-                      3.0+M_PI/2.0, 0.0);
-            cairo_line_to(cr, box_area.x + box_area.width,
-                          box_area.y + box_area.height - LABEL_RADIUS);
-            cairo_arc(cr, box_area.x + box_area.width - LABEL_RADIUS,
-                      box_area.y + box_area.height - LABEL_RADIUS,
-                      LABEL_RADIUS,
-                      0.0, M_PI/2.0);
-            cairo_line_to(cr, box_area.x + LABEL_RADIUS,
-                          box_area.y + box_area.height);
-            cairo_arc(cr, box_area.x + LABEL_RADIUS,
-                      box_area.y + box_area.height - LABEL_RADIUS,
-                      LABEL_RADIUS,
-                      M_PI/2.0, M_PI);
-            cairo_close_path(cr);
-        }
+    cairo_set_source_rgba(cr, style->base[state].red / 65535.,
+                          style->base[state].green / 65535.,
+                          style->base[state].blue / 65535.,
+                          alpha);
+
+    if(LABEL_RADIUS < 0.1)
+        gdk_cairo_rectangle(cr, &box_area);
+    else {
+        cairo_move_to(cr, box_area.x, box_area.y + LABEL_RADIUS);
+        cairo_arc(cr, box_area.x + LABEL_RADIUS,
+                  box_area.y + LABEL_RADIUS, LABEL_RADIUS,
+                  M_PI, 3.0*M_PI/2.0);
+        cairo_line_to(cr, box_area.x + box_area.width - LABEL_RADIUS,
+                      box_area.y);
+        cairo_arc(cr, box_area.x + box_area.width - LABEL_RADIUS,
+                  box_area.y + LABEL_RADIUS, LABEL_RADIUS,
+                  3.0+M_PI/2.0, 0.0);
+        cairo_line_to(cr, box_area.x + box_area.width,
+                      box_area.y + box_area.height - LABEL_RADIUS);
+        cairo_arc(cr, box_area.x + box_area.width - LABEL_RADIUS,
+                  box_area.y + box_area.height - LABEL_RADIUS,
+                  LABEL_RADIUS,
+                  0.0, M_PI/2.0);
+        cairo_line_to(cr, box_area.x + LABEL_RADIUS,
+                      box_area.y + box_area.height);
+        cairo_arc(cr, box_area.x + LABEL_RADIUS,
+                  box_area.y + box_area.height - LABEL_RADIUS,
+                  LABEL_RADIUS,
+                  M_PI/2.0, M_PI);
+        cairo_close_path(cr);
+    }
 
-        cairo_fill(cr);
+    cairo_fill(cr);
 
-        cairo_destroy(cr);
-    }
+    cairo_restore(cr);
 }
 
 static gboolean
@@ -2921,42 +3201,102 @@ xfdesktop_icon_view_calculate_icon_pixbuf_area(XfdesktopIconView *icon_view,
 
 static void
 xfdesktop_icon_view_setup_pango_layout(XfdesktopIconView *icon_view,
-                                       XfdesktopIcon *icon,
-                                       PangoLayout *playout)
+                                       PangoLayout *playout,
+                                       const gchar *label,
+                                       gboolean truncate)
 {
-    const gchar *label = xfdesktop_icon_peek_label(icon);
-
-    g_return_if_fail(XFDESKTOP_IS_ICON_VIEW(icon_view)
-                     && XFDESKTOP_IS_ICON(icon));
-
     pango_layout_set_ellipsize(playout, PANGO_ELLIPSIZE_NONE);
     pango_layout_set_wrap(playout, PANGO_WRAP_WORD_CHAR);
     pango_layout_set_width(playout, TEXT_WIDTH * PANGO_SCALE);
+    pango_layout_set_height(playout, -1);
     pango_layout_set_text(playout, label, -1);
 
-    if(!xfdesktop_icon_view_is_icon_selected(icon_view, icon)
-       && icon_view->priv->ellipsize_icon_labels) {
+    if(truncate) {
         /* constrain the text area */
         pango_layout_set_height(playout, TEXT_HEIGHT * PANGO_SCALE);
         pango_layout_set_ellipsize(playout, PANGO_ELLIPSIZE_END);
     }
 }
 
+static void
+xfdesktop_icon_view_label_metrics_free(gpointer data)
+{
+    XfdesktopIconLabelMetrics *metrics = data;
+    gint i;
+
+    for(i = 0; i < LABEL_N_VARIANTS; ++i) {
+        if(metrics->layout[i])
+            g_object_unref(G_OBJECT(metrics->layout[i]));
+    }
+    g_free(metrics->label);
+    g_slice_free(XfdesktopIconLabelMetrics, metrics);
+}
+
+static void
+xfdesktop_icon_view_label_metrics_flush(XfdesktopIconView *icon_view)
+{
+    g_hash_table_remove_all(icon_view->priv->label_metrics);
+}
+
+/* returns the label layout @icon is drawn with in its current selection
+ * state, laying it out only if the label or the label style changed since
+ * the last call */
+static PangoLayout *
+xfdesktop_icon_view_get_label_layout(XfdesktopIconView *icon_view,
+                                     XfdesktopIcon *icon,
+                                     PangoRectangle *extents)
+{
+    XfdesktopIconLabelMetrics *metrics;
+    const gchar *label = xfdesktop_icon_peek_label(icon);
+    gint variant;
+
+    if(!xfdesktop_icon_view_is_icon_selected(icon_view, icon)
+       && icon_view->priv->ellipsize_icon_labels)
+    {
+        variant = LABEL_VARIANT_TRUNCATED;
+    } else
+        variant = LABEL_VARIANT_FULL;
+
+    metrics = g_hash_table_lookup(icon_view->priv->label_metrics, icon);
+    if(metrics && g_strcmp0(metrics->label, label)) {
+        g_hash_table_remove(icon_view->priv->label_metrics, icon);
+        metrics = NULL;
+    }
+
+    if(!metrics) {
+        metrics = g_slice_new0(XfdesktopIconLabelMetrics);
+        metrics->label = g_strdup(label);
+        g_hash_table_insert(icon_view->priv->label_metrics, icon, metrics);
+    }
+
+    if(!metrics->layout[variant]) {
+        metrics->layout[variant] = pango_layout_copy(icon_view->priv->playout);
+        xfdesktop_icon_view_setup_pango_layout(icon_view,
+                                               metrics->layout[variant],
+                                               label,
+                                               variant == LABEL_VARIANT_TRUNCATED);
+        pango_layout_get_pixel_extents(metrics->layout[variant], NULL,
+                                       &metrics->extents[variant]);
+    }
+
+    if(extents)
+        *extents = metrics->extents[variant];
+
+    return metrics->layout[variant];
+}
+
 static gboolean
 xfdesktop_icon_view_calculate_icon_text_area(XfdesktopIconView *icon_view,
                                              XfdesktopIcon *icon,
                                              GdkRectangle *text_area)
 {
-    PangoLayout *playout;
     PangoRectangle prect;
 
     g_return_val_if_fail(XFDESKTOP_IS_ICON_VIEW(icon_view)
                          && XFDESKTOP_IS_ICON(icon)
                          && text_area, FALSE);
 
-    playout = icon_view->priv->playout;
-    xfdesktop_icon_view_setup_pango_layout(icon_view, icon, playout);
-    pango_layout_get_pixel_extents(playout, NULL, &prect);
+    xfdesktop_icon_view_get_label_layout(icon_view, icon, &prect);
 
     text_area->x = prect.x;
     text_area->y = prect.y;
@@ -2993,7 +3333,7 @@ xfdesktop_icon_view_update_icon_extents(XfdesktopIconView *icon_view,
                                         GdkRectangle *total_extents,
                                         gint *rtl_offset)
 {
-    GdkRectangle tmp_text;
+    GdkRectangle tmp_text, cell;
 
     g_return_val_if_fail(XFDESKTOP_IS_ICON_VIEW(icon_view)
                          && XFDESKTOP_IS_ICON(icon)
@@ -3032,6 +3372,16 @@ xfdesktop_icon_view_update_icon_extents(XfdesktopIconView *icon_view,
 
     xfdesktop_icon_set_extents(icon, pixbuf_extents, text_extents, total_extents);
 
+    /* the expose path only looks at the cells it was asked to repaint, so
+     * remember which icons draw outside of theirs */
+    cell.x = cell.y = 0;
+    cell.width = cell.height = CELL_SIZE;
+    xfdesktop_icon_view_shift_area_to_cell(icon_view, icon, &cell);
+    if(xfdesktop_rectangle_is_bounded_by(total_extents, &cell))
+        g_hash_table_remove(icon_view->priv->overflow_icons, icon);
+    else
+        g_hash_table_insert(icon_view->priv->overflow_icons, icon, icon);
+
     return TRUE;
 }
 
@@ -3061,82 +3411,157 @@ xfdesktop_icon_view_draw_text(cairo_t *cr, PangoLayout *playout,
 }
 
 static void
-xfdesktop_icon_view_paint_icon(XfdesktopIconView *icon_view,
-                               XfdesktopIcon *icon,
-                               GdkRectangle *area)
+xfdesktop_icon_view_cell_cache_entry_free(gpointer data)
 {
-    GtkWidget *widget = GTK_WIDGET(icon_view);
-    gint state, rtl_offset;
-    PangoLayout *playout;
-    GdkRectangle pixbuf_extents, text_extents, total_extents;
-    GdkRectangle intersection;
-    gchar x_offset = 0, y_offset = 0;
-    GdkColor *sh_text_col = NULL;
-    cairo_t *cr;
+    XfdesktopIconCellCacheEntry *entry = data;
 
-    TRACE("entering, (%s)(area=%dx%d+%d+%d)", xfdesktop_icon_peek_label(icon),
-          area->width, area->height, area->x, area->y);
+    cairo_surface_destroy(entry->surface);
+    if(entry->pix)
+        g_object_unref(G_OBJECT(entry->pix));
+    g_slice_free(XfdesktopIconCellCacheEntry, entry);
+}
 
-    playout = icon_view->priv->playout;
+static void
+xfdesktop_icon_view_cell_cache_remove(XfdesktopIconView *icon_view,
+                                      XfdesktopIcon *icon)
+{
+    XfdesktopIconCellCacheEntry *entry;
 
-    cr = gdk_cairo_create(GDK_DRAWABLE(gtk_widget_get_window(widget)));
-    
-    if(!xfdesktop_icon_get_extents(icon, &pixbuf_extents,
-                                   &text_extents, &total_extents))
+    entry = g_hash_table_lookup(icon_view->priv->cell_cache, icon);
+    if(!entry)
+        return;
+
+    g_queue_delete_link(&icon_view->priv->cell_cache_lru, entry->lru_link);
+    icon_view->priv->cell_cache_size -= entry->size;
+    g_hash_table_remove(icon_view->priv->cell_cache, icon);
+}
+
+static void
+xfdesktop_icon_view_cell_cache_flush(XfdesktopIconView *icon_view)
+{
+    g_queue_clear(&icon_view->priv->cell_cache_lru);
+    g_hash_table_remove_all(icon_view->priv->cell_cache);
+    icon_view->priv->cell_cache_size = 0;
+}
+
+static void
+xfdesktop_icon_view_cell_cache_insert(XfdesktopIconView *icon_view,
+                                      XfdesktopIconCellCacheEntry *entry)
+{
+    GQueue *lru = &icon_view->priv->cell_cache_lru;
+
+    g_queue_push_head(lru, entry);
+    entry->lru_link = lru->head;
+    g_hash_table_insert(icon_view->priv->cell_cache, entry->icon, entry);
+    icon_view->priv->cell_cache_size += entry->size;
+
+    /* drop the least recently painted cells until we're under the cap, but
+     * never the one we're about to paint */
+    while(icon_view->priv->cell_cache_size > CELL_CACHE_MAX_BYTES
+          && lru->tail && lru->tail->data != entry)
     {
-        g_warning("Can't get extents for icon '%s'", xfdesktop_icon_peek_label(icon));
+        XfdesktopIconCellCacheEntry *old = lru->tail->data;
+        xfdesktop_icon_view_cell_cache_remove(icon_view, old->icon);
     }
+}
 
-    if(!xfdesktop_icon_view_update_icon_extents(icon_view, icon,
-                                                &pixbuf_extents,
-                                                &text_extents,
-                                                &total_extents,
-                                                &rtl_offset))
-    {
-        g_warning("Can't update extents for icon '%s'",
-                  xfdesktop_icon_peek_label(icon));
+static void
+xfdesktop_icon_view_state_pixbufs_free(gpointer data)
+{
+    XfdesktopIconStatePixbufs *pixbufs = data;
+    gint i;
+
+    /* variant 0 is a borrowed pointer to the source */
+    for(i = 1; i < STATE_PIXBUF_N_VARIANTS; ++i) {
+        if(pixbufs->variants[i])
+            g_object_unref(G_OBJECT(pixbufs->variants[i]));
     }
+    g_object_unref(G_OBJECT(pixbufs->source));
+    g_slice_free(XfdesktopIconStatePixbufs, pixbufs);
+}
 
-    if(xfdesktop_icon_view_is_icon_selected(icon_view, icon)) {
-        if(gtk_widget_has_focus(widget))
-            state = GTK_STATE_SELECTED;
-        else
-            state = GTK_STATE_ACTIVE;
-    } else
-        state = GTK_STATE_NORMAL;
-    
-    if(gdk_rectangle_intersect(area, &pixbuf_extents, &intersection)) {
-        GdkPixbuf *pix = xfdesktop_icon_peek_pixbuf(icon, ICON_WIDTH, ICON_SIZE);
-        GdkPixbuf *pix_free = NULL;
+/* returns @pix as it should be drawn for @icon in @state, deriving it from
+ * @pix only the first time that state is requested.  the returned pixbuf
+ * is owned by the icon view. */
+static GdkPixbuf *
+xfdesktop_icon_view_get_state_pixbuf(XfdesktopIconView *icon_view,
+                                     XfdesktopIcon *icon,
+                                     GdkPixbuf *pix,
+                                     GtkStateType state,
+                                     gboolean prelit)
+{
+    XfdesktopIconStatePixbufs *pixbufs;
+    gint base, idx;
 
-        if(state != GTK_STATE_NORMAL) {
-            pix_free = exo_gdk_pixbuf_colorize(pix, &gtk_widget_get_style(widget)->base[state]);
-            pix = pix_free;
-        }
+    if(state == GTK_STATE_SELECTED)
+        base = 2;
+    else if(state == GTK_STATE_ACTIVE)
+        base = 4;
+    else
+        base = 0;
+    idx = base + (prelit ? 1 : 0);
 
-        if(icon_view->priv->item_under_pointer == icon) {
-            GdkPixbuf *tmp = exo_gdk_pixbuf_spotlight(pix);
-            if(pix_free)
-                g_object_unref(G_OBJECT(pix_free));
-            pix = tmp;
-            pix_free = tmp;
-        }
+    pixbufs = g_hash_table_lookup(icon_view->priv->state_pixbufs, icon);
+    if(pixbufs && pixbufs->source != pix) {
+        g_hash_table_remove(icon_view->priv->state_pixbufs, icon);
+        pixbufs = NULL;
+    }
+
+    if(!pixbufs) {
+        pixbufs = g_slice_new0(XfdesktopIconStatePixbufs);
+        pixbufs->source = g_object_ref(G_OBJECT(pix));
+        pixbufs->variants[0] = pix;
+        g_hash_table_insert(icon_view->priv->state_pixbufs, icon, pixbufs);
+    }
+
+    if(!pixbufs->variants[base]) {
+        GtkStyle *style = gtk_widget_get_style(GTK_WIDGET(icon_view));
+        pixbufs->variants[base] = xfdesktop_pixbuf_colorize(pix,
+                                                            &style->base[state]);
+    }
+
+    if(!pixbufs->variants[idx])
+        pixbufs->variants[idx] = xfdesktop_pixbuf_spotlight(pixbufs->variants[base]);
+
+    return pixbufs->variants[idx];
+}
+
+/* renders the complete cell for @icon into an image surface the size of
+ * @total_extents; all extents are in widget coordinates */
+static cairo_surface_t *
+xfdesktop_icon_view_render_cell(XfdesktopIconView *icon_view,
+                                GdkPixbuf *pix,
+                                PangoLayout *playout,
+                                GtkStateType state,
+                                gboolean prelit,
+                                GdkRectangle *pixbuf_extents,
+                                GdkRectangle *text_extents,
+                                GdkRectangle *total_extents,
+                                gint rtl_offset)
+{
+    GtkWidget *widget = GTK_WIDGET(icon_view);
+    cairo_surface_t *surface;
+    cairo_t *cr;
+
+    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                                         total_extents->width,
+                                         total_extents->height);
+    cr = cairo_create(surface);
+    cairo_translate(cr, -total_extents->x, -total_extents->y);
 
+    if(pix) {
         TRACE("painting pixbuf at %dx%d+%d+%d",
-              pixbuf_extents.width, pixbuf_extents.height,
-              pixbuf_extents.x, pixbuf_extents.y);
+              pixbuf_extents->width, pixbuf_extents->height,
+              pixbuf_extents->x, pixbuf_extents->y);
 
-        xfdesktop_icon_view_draw_image(cr, pix, &pixbuf_extents);
-        
-        if(pix_free)
-            g_object_unref(G_OBJECT(pix_free));
+        xfdesktop_icon_view_draw_image(cr, pix, pixbuf_extents);
     }
 
-    /* Only redraw the text if the text area requires it.  */
-    if(gdk_rectangle_intersect(area, &text_extents, &intersection)
-       && icon_view->priv->font_size > 0)
-    {
-        xfdesktop_paint_rounded_box(icon_view, state, &text_extents, area);
+    if(icon_view->priv->font_size > 0) {
+        gchar x_offset = 0, y_offset = 0;
+        GdkColor *sh_text_col = NULL;
+
+        xfdesktop_paint_rounded_box(icon_view, cr, state, text_extents);
 
         if (state == GTK_STATE_NORMAL) {
             x_offset = icon_view->priv->shadow_x_offset;
@@ -3151,22 +3576,125 @@ xfdesktop_icon_view_paint_icon(XfdesktopIconView *icon_view,
         /* draw text shadow for the label text if an offset was defined */
         if(x_offset || y_offset) {
             xfdesktop_icon_view_draw_text(cr, playout,
-                                          text_extents.x + x_offset,
-                                          text_extents.y + y_offset,
+                                          text_extents->x + x_offset,
+                                          text_extents->y + y_offset,
                                           rtl_offset,
                                           sh_text_col);
         }
 
         TRACE("painting text at %dx%d+%d+%d",
-              text_extents.width, text_extents.height,
-              text_extents.x, text_extents.y);
+              text_extents->width, text_extents->height,
+              text_extents->x, text_extents->y);
+
+        /* same color gtk_paint_layout() uses for a non-text widget */
+        xfdesktop_icon_view_draw_text(cr, playout,
+                                      text_extents->x, text_extents->y, 0,
+                                      &gtk_widget_get_style(widget)->fg[state]);
+    }
+
+    cairo_destroy(cr);
+
+    return surface;
+}
 
-        gtk_paint_layout(gtk_widget_get_style(widget), gtk_widget_get_window(widget),
-                         state, FALSE, area, widget, "label",
-                         text_extents.x, text_extents.y, playout);
+static void
+xfdesktop_icon_view_paint_icon(XfdesktopIconView *icon_view,
+                               XfdesktopIcon *icon,
+                               GdkRectangle *area)
+{
+    GtkWidget *widget = GTK_WIDGET(icon_view);
+    gint state, rtl_offset;
+    gboolean prelit;
+    GdkPixbuf *pix, *state_pix;
+    PangoLayout *playout;
+    GdkRectangle pixbuf_extents, text_extents, total_extents;
+    XfdesktopIconCellCacheEntry *entry;
+    cairo_t *cr;
+
+    TRACE("entering, (%s)(area=%dx%d+%d+%d)", xfdesktop_icon_peek_label(icon),
+          area->width, area->height, area->x, area->y);
+
+    xfdesktop_icon_exposed(icon);
+
+    if(!xfdesktop_icon_get_extents(icon, &pixbuf_extents,
+                                   &text_extents, &total_extents))
+    {
+        g_warning("Can't get extents for icon '%s'", xfdesktop_icon_peek_label(icon));
+    }
+
+    if(!xfdesktop_icon_view_update_icon_extents(icon_view, icon,
+                                                &pixbuf_extents,
+                                                &text_extents,
+                                                &total_extents,
+                                                &rtl_offset))
+    {
+        g_warning("Can't update extents for icon '%s'",
+                  xfdesktop_icon_peek_label(icon));
+    }
+
+    if(xfdesktop_icon_view_is_icon_selected(icon_view, icon)) {
+        if(gtk_widget_has_focus(widget))
+            state = GTK_STATE_SELECTED;
+        else
+            state = GTK_STATE_ACTIVE;
+    } else
+        state = GTK_STATE_NORMAL;
+
+    prelit = (icon_view->priv->item_under_pointer == icon);
+    pix = xfdesktop_icon_peek_pixbuf(icon, ICON_WIDTH, ICON_SIZE);
+
+    entry = g_hash_table_lookup(icon_view->priv->cell_cache, icon);
+    if(entry
+       && (entry->state != state || entry->prelit != prelit
+           || entry->pix != pix
+           || cairo_image_surface_get_width(entry->surface) != total_extents.width
+           || cairo_image_surface_get_height(entry->surface) != total_extents.height))
+    {
+        xfdesktop_icon_view_cell_cache_remove(icon_view, icon);
+        entry = NULL;
+    }
 
+    if(entry) {
+        icon_view->priv->cell_cache_hits++;
+        g_queue_unlink(&icon_view->priv->cell_cache_lru, entry->lru_link);
+        g_queue_push_head_link(&icon_view->priv->cell_cache_lru, entry->lru_link);
+    } else {
+        icon_view->priv->cell_cache_misses++;
+
+        /* already laid out by the extents update above */
+        playout = xfdesktop_icon_view_get_label_layout(icon_view, icon, NULL);
+        state_pix = pix ? xfdesktop_icon_view_get_state_pixbuf(icon_view, icon,
+                                                               pix, state,
+                                                               prelit)
+                        : NULL;
+
+        entry = g_slice_new0(XfdesktopIconCellCacheEntry);
+        entry->icon = icon;
+        entry->state = state;
+        entry->prelit = prelit;
+        entry->pix = pix ? g_object_ref(G_OBJECT(pix)) : NULL;
+        entry->surface = xfdesktop_icon_view_render_cell(icon_view,
+                                                         state_pix,
+                                                         playout,
+                                                         state, prelit,
+                                                         &pixbuf_extents,
+                                                         &text_extents,
+                                                         &total_extents,
+                                                         rtl_offset);
+        entry->size = (gsize)cairo_image_surface_get_stride(entry->surface)
+                      * cairo_image_surface_get_height(entry->surface);
+        xfdesktop_icon_view_cell_cache_insert(icon_view, entry);
     }
 
+    cr = gdk_cairo_create(GDK_DRAWABLE(gtk_widget_get_window(widget)));
+
+    /* restrict painting to expose area */
+    gdk_cairo_rectangle(cr, area);
+    cairo_clip(cr);
+
+    cairo_set_source_surface(cr, entry->surface,
+                             total_extents.x, total_extents.y);
+    cairo_paint(cr);
 
 #if 0 /*def DEBUG*/
     {
@@ -3233,9 +3761,13 @@ xfdesktop_move_all_icons_to_pending_icons_list(XfdesktopIconView *icon_view)
                                                    icon_view->priv->pending_icons);
     icon_view->priv->icons = NULL;
 
+    xfdesktop_icon_view_cell_cache_flush(icon_view);
+    g_hash_table_remove_all(icon_view->priv->overflow_icons);
+
     memset(icon_view->priv->grid_layout, 0,
            (guint)icon_view->priv->nrows * icon_view->priv->ncols
            * sizeof(XfdesktopIcon *));
+    xfdesktop_grid_reset_free_map(icon_view);
     
     xfdesktop_setup_grids(icon_view);
 }
@@ -3365,9 +3897,11 @@ xfdesktop_move_all_pending_icons_to_desktop(XfdesktopIconView *icon_view)
     if(icon_view->priv->grid_layout == NULL)
         return;
 
+    xfdesktop_icon_view_begin_batch(icon_view);
     xfdesktop_move_all_cached_icons_to_desktop(icon_view);
     xfdesktop_move_all_previous_icons_to_desktop(icon_view);
     xfdesktop_append_all_pending_icons(icon_view);
+    xfdesktop_icon_view_end_batch(icon_view);
 }
 
 static void
@@ -3412,6 +3946,7 @@ xfdesktop_grid_do_resize(XfdesktopIconView *icon_view)
     memset(icon_view->priv->grid_layout, 0,
            (guint)icon_view->priv->nrows * icon_view->priv->ncols
            * sizeof(XfdesktopIcon *));
+    xfdesktop_grid_reset_free_map(icon_view);
     
     xfdesktop_setup_grids(icon_view);
 
@@ -3533,25 +4068,80 @@ xfdesktop_grid_is_free_position(XfdesktopIconView *icon_view,
 }
 
 
+static inline gint
+xfdesktop_grid_first_set_bit(guint64 word)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    gint bit = 0;
+
+    while(!(word & 1)) {
+        word >>= 1;
+        ++bit;
+    }
+
+    return bit;
+#endif
+}
+
+/* rebuilds grid_free_map from the current contents of grid_layout; needed
+ * whenever grid_layout is reallocated or cleared wholesale */
+static void
+xfdesktop_grid_reset_free_map(XfdesktopIconView *icon_view)
+{
+    gint i, maxi, nwords;
+
+    maxi = icon_view->priv->nrows * icon_view->priv->ncols;
+    nwords = (maxi + 63) / 64;
+
+    g_free(icon_view->priv->grid_free_map);
+    icon_view->priv->grid_free_map = g_new0(guint64, MAX(nwords, 1));
+    icon_view->priv->grid_free_cursor = 0;
+
+    for(i = 0; i < maxi; ++i) {
+        if(!icon_view->priv->grid_layout[i])
+            icon_view->priv->grid_free_map[i / 64] |= G_GUINT64_CONSTANT(1) << (i % 64);
+    }
+}
+
 static gboolean
 xfdesktop_grid_get_next_free_position(XfdesktopIconView *icon_view,
                                       guint16 *row,
                                       guint16 *col)
 {
-    gint i, maxi;
+    gint w, nwords, i;
+    guint64 word;
     
     g_return_val_if_fail(row && col, FALSE);
+
+    if(!icon_view->priv->grid_free_map)
+        return FALSE;
     
-    maxi = icon_view->priv->nrows * icon_view->priv->ncols;
-    for(i = 0; i < maxi; ++i) {
-        if(!icon_view->priv->grid_layout[i]) {
-            *row = i % icon_view->priv->nrows;
-            *col = i / icon_view->priv->nrows;
-            return TRUE;
+    nwords = (icon_view->priv->nrows * icon_view->priv->ncols + 63) / 64;
+    w = icon_view->priv->grid_free_cursor / 64;
+    if(w >= nwords)
+        return FALSE;
+
+    /* ignore the cells before the cursor in its word; they're all taken */
+    word = icon_view->priv->grid_free_map[w]
+           & (~G_GUINT64_CONSTANT(0) << (icon_view->priv->grid_free_cursor % 64));
+
+    while(!word) {
+        if(++w >= nwords) {
+            icon_view->priv->grid_free_cursor = nwords * 64;
+            return FALSE;
         }
+        word = icon_view->priv->grid_free_map[w];
     }
+
+    i = w * 64 + xfdesktop_grid_first_set_bit(word);
+    icon_view->priv->grid_free_cursor = i;
+
+    *row = i % icon_view->priv->nrows;
+    *col = i / icon_view->priv->nrows;
     
-    return FALSE;
+    return TRUE;
 }
 
 
@@ -3560,6 +4150,8 @@ xfdesktop_grid_set_position_free(XfdesktopIconView *icon_view,
                                  guint16 row,
                                  guint16 col)
 {
+    gint idx;
+
     g_return_if_fail(row < icon_view->priv->nrows
                      && col < icon_view->priv->ncols);
     
@@ -3567,7 +4159,11 @@ xfdesktop_grid_set_position_free(XfdesktopIconView *icon_view,
     DUMP_GRID_LAYOUT(icon_view);
 #endif
 
-    icon_view->priv->grid_layout[col * icon_view->priv->nrows + row] = NULL;
+    idx = col * icon_view->priv->nrows + row;
+    icon_view->priv->grid_layout[idx] = NULL;
+    icon_view->priv->grid_free_map[idx / 64] |= G_GUINT64_CONSTANT(1) << (idx % 64);
+    if(idx < icon_view->priv->grid_free_cursor)
+        icon_view->priv->grid_free_cursor = idx;
 
 #if 0 /*def DEBUG*/
     DUMP_GRID_LAYOUT(icon_view);
@@ -3594,6 +4190,7 @@ xfdesktop_grid_unset_position_free_raw(XfdesktopIconView *icon_view,
 #endif
 
     icon_view->priv->grid_layout[idx] = data;
+    icon_view->priv->grid_free_map[idx / 64] &= ~(G_GUINT64_CONSTANT(1) << (idx % 64));
 
 #if 0 /*def DEBUG*/
     DUMP_GRID_LAYOUT(icon_view);
@@ -3672,15 +4269,6 @@ xfdesktop_check_icon_clicked(gconstpointer data,
         return 1;
 }
 
-static void
-xfdesktop_list_foreach_invalidate(gpointer data,
-                                  gpointer user_data)
-{
-    XfdesktopIconView *icon_view = XFDESKTOP_ICON_VIEW(user_data);
-    XfdesktopIcon *icon = XFDESKTOP_ICON(data);
-    xfdesktop_icon_view_invalidate_icon(icon_view, icon, TRUE);
-}
-
 static void
 xfdesktop_icon_view_modify_font_size(XfdesktopIconView *icon_view,
                                      gdouble size)
@@ -3705,6 +4293,11 @@ static void
 xfdesktop_icon_view_icon_changed(XfdesktopIcon *icon,
                                  gpointer user_data)
 {
+    xfdesktop_icon_view_cell_cache_remove(XFDESKTOP_ICON_VIEW(user_data),
+                                          icon);
+    g_hash_table_remove(XFDESKTOP_ICON_VIEW(user_data)->priv->state_pixbufs,
+                        icon);
+
     /* maybe can pass FALSE here */
     xfdesktop_icon_view_invalidate_icon(XFDESKTOP_ICON_VIEW(user_data),
                                         icon, TRUE);
@@ -3714,7 +4307,89 @@ static gboolean
 xfdesktop_icon_view_is_icon_selected(XfdesktopIconView *icon_view,
                                      XfdesktopIcon *icon)
 {
-    return (g_list_find(icon_view->priv->selected_icons, icon)) == NULL ? FALSE : TRUE;
+    return g_hash_table_lookup(icon_view->priv->selected_set, icon) != NULL;
+}
+
+/* adds @icon to the head of the selection; returns FALSE if it was
+ * already selected */
+static gboolean
+xfdesktop_icon_view_selection_add(XfdesktopIconView *icon_view,
+                                  XfdesktopIcon *icon)
+{
+    if(xfdesktop_icon_view_is_icon_selected(icon_view, icon))
+        return FALSE;
+
+    icon_view->priv->selected_icons = g_list_prepend(icon_view->priv->selected_icons,
+                                                     icon);
+    g_hash_table_insert(icon_view->priv->selected_set, icon,
+                        icon_view->priv->selected_icons);
+
+    return TRUE;
+}
+
+/* returns FALSE if @icon wasn't selected */
+static gboolean
+xfdesktop_icon_view_selection_remove(XfdesktopIconView *icon_view,
+                                     XfdesktopIcon *icon)
+{
+    GList *link = g_hash_table_lookup(icon_view->priv->selected_set, icon);
+
+    if(!link)
+        return FALSE;
+
+    icon_view->priv->selected_icons = g_list_delete_link(icon_view->priv->selected_icons,
+                                                         link);
+    g_hash_table_remove(icon_view->priv->selected_set, icon);
+
+    return TRUE;
+}
+
+static void
+xfdesktop_icon_view_selection_clear(XfdesktopIconView *icon_view)
+{
+    g_list_free(icon_view->priv->selected_icons);
+    icon_view->priv->selected_icons = NULL;
+    g_hash_table_remove_all(icon_view->priv->selected_set);
+}
+
+/* like xfdesktop_icon_view_invalidate_icon(), but adds the icon's old and
+ * new extents to @damage instead of queueing a redraw for each of them */
+static void
+xfdesktop_icon_view_damage_icon(XfdesktopIconView *icon_view,
+                                XfdesktopIcon *icon,
+                                GdkRegion *damage)
+{
+    GdkRectangle extents, pixbuf_extents, text_extents;
+    gint rtl_offset;
+
+    if(xfdesktop_icon_get_extents(icon, NULL, NULL, &extents))
+        gdk_region_union_with_rect(damage, &extents);
+
+    if(xfdesktop_icon_view_update_icon_extents(icon_view, icon,
+                                               &pixbuf_extents,
+                                               &text_extents,
+                                               &extents,
+                                               &rtl_offset))
+    {
+        gdk_region_union_with_rect(damage, &extents);
+    }
+}
+
+/* queues a redraw of @damage, frees it, and tells everyone the selection
+ * changed */
+static void
+xfdesktop_icon_view_selection_changed(XfdesktopIconView *icon_view,
+                                      GdkRegion *damage)
+{
+    GtkWidget *widget = GTK_WIDGET(icon_view);
+
+    if(gtk_widget_get_realized(widget))
+        gdk_window_invalidate_region(gtk_widget_get_window(widget), damage, FALSE);
+    gdk_region_destroy(damage);
+
+    g_signal_emit(G_OBJECT(icon_view),
+                  __signals[SIG_ICON_SELECTION_CHANGED],
+                  0, NULL);
 }
 
 
@@ -3781,7 +4456,13 @@ xfdesktop_icon_view_add_item_internal(XfdesktopIconView *icon_view,
     fake_area.x = SCREEN_MARGIN + icon_view->priv->xorigin + col * CELL_SIZE;
     fake_area.y = SCREEN_MARGIN + icon_view->priv->yorigin + row * CELL_SIZE;
     fake_area.width = fake_area.height = CELL_SIZE;
-    xfdesktop_icon_view_paint_icon(icon_view, icon, &fake_area);
+
+    if(icon_view->priv->batch_damage) {
+        gdk_region_union_with_rect(icon_view->priv->batch_damage, &fake_area);
+        xfdesktop_icon_view_damage_icon(icon_view, icon,
+                                        icon_view->priv->batch_damage);
+    } else
+        xfdesktop_icon_view_paint_icon(icon_view, icon, &fake_area);
 }
 
 static gboolean
@@ -3806,21 +4487,32 @@ xfdesktop_icon_view_icon_find_position(XfdesktopIconView *icon_view,
     return TRUE;
 }
 
+static gboolean
+xfdesktop_icon_view_claim_item(XfdesktopIconView *icon_view,
+                               XfdesktopIcon *icon)
+{
+    g_return_val_if_fail(XFDESKTOP_IS_ICON(icon), FALSE);
+
+    /* ensure the icon isn't already in an icon view */
+    g_return_val_if_fail(!g_object_get_data(G_OBJECT(icon),
+                                            "--xfdesktop-icon-view"), FALSE);
+
+    g_object_set_data(G_OBJECT(icon), "--xfdesktop-icon-view", icon_view);
+    g_object_ref(G_OBJECT(icon));
+
+    return TRUE;
+}
+
 void
 xfdesktop_icon_view_add_item(XfdesktopIconView *icon_view,
                              XfdesktopIcon *icon)
 {
     guint16 row, col;
     
-    g_return_if_fail(XFDESKTOP_IS_ICON_VIEW(icon_view)
-                     && XFDESKTOP_IS_ICON(icon));
-    
-    /* ensure the icon isn't already in an icon view */
-    g_return_if_fail(!g_object_get_data(G_OBJECT(icon),
-                                        "--xfdesktop-icon-view"));
-    
-    g_object_set_data(G_OBJECT(icon), "--xfdesktop-icon-view", icon_view);
-    g_object_ref(G_OBJECT(icon));
+    g_return_if_fail(XFDESKTOP_IS_ICON_VIEW(icon_view));
+
+    if(!xfdesktop_icon_view_claim_item(icon_view, icon))
+        return;
     
     if(!gtk_widget_get_realized(GTK_WIDGET(icon_view))) {
         /* if we aren't realized, we don't know what our grid looks like, so
@@ -3842,6 +4534,89 @@ xfdesktop_icon_view_add_item(XfdesktopIconView *icon_view,
     }
 }
 
+/* adds all of @icons in one go: first every icon whose saved position is
+ * still free, so that icons without one can't take it from them, then the
+ * rest in order wherever there is room.  the whole lot is painted once. */
+void
+xfdesktop_icon_view_add_items(XfdesktopIconView *icon_view,
+                              GList *icons)
+{
+    GList *l, *unplaced = NULL;
+    guint16 row, col;
+
+    g_return_if_fail(XFDESKTOP_IS_ICON_VIEW(icon_view));
+
+    if(!gtk_widget_get_realized(GTK_WIDGET(icon_view))) {
+        for(l = icons; l; l = l->next)
+            xfdesktop_icon_view_add_item(icon_view, XFDESKTOP_ICON(l->data));
+        return;
+    }
+
+    xfdesktop_icon_view_begin_batch(icon_view);
+
+    for(l = icons; l; l = l->next) {
+        XfdesktopIcon *icon = l->data;
+
+        if(!xfdesktop_icon_view_claim_item(icon_view, icon))
+            continue;
+
+        if(xfdesktop_icon_get_position(icon, &row, &col)
+           && xfdesktop_grid_is_free_position(icon_view, row, col))
+        {
+            xfdesktop_icon_view_add_item_internal(icon_view, icon);
+        } else
+            unplaced = g_list_prepend(unplaced, icon);
+    }
+
+    unplaced = g_list_reverse(unplaced);
+    for(l = unplaced; l; l = l->next) {
+        XfdesktopIcon *icon = l->data;
+
+        if(xfdesktop_icon_view_icon_find_position(icon_view, icon))
+            xfdesktop_icon_view_add_item_internal(icon_view, icon);
+        else {
+            icon_view->priv->pending_icons = g_list_append(icon_view->priv->pending_icons,
+                                                           icon);
+        }
+    }
+    g_list_free(unplaced);
+
+    xfdesktop_icon_view_end_batch(icon_view);
+}
+
+/* starts a batch of insertions: icons added before the matching
+ * xfdesktop_icon_view_end_batch() aren't painted one at a time, but all
+ * together afterwards.  batches may be nested. */
+void
+xfdesktop_icon_view_begin_batch(XfdesktopIconView *icon_view)
+{
+    g_return_if_fail(XFDESKTOP_IS_ICON_VIEW(icon_view));
+
+    if(icon_view->priv->batch_depth++ == 0)
+        icon_view->priv->batch_damage = gdk_region_new();
+}
+
+void
+xfdesktop_icon_view_end_batch(XfdesktopIconView *icon_view)
+{
+    GtkWidget *widget = GTK_WIDGET(icon_view);
+
+    g_return_if_fail(XFDESKTOP_IS_ICON_VIEW(icon_view));
+    g_return_if_fail(icon_view->priv->batch_depth > 0);
+
+    if(--icon_view->priv->batch_depth > 0)
+        return;
+
+    if(gtk_widget_get_realized(widget)
+       && !gdk_region_empty(icon_view->priv->batch_damage))
+    {
+        gdk_window_invalidate_region(gtk_widget_get_window(widget),
+                                     icon_view->priv->batch_damage, FALSE);
+    }
+    gdk_region_destroy(icon_view->priv->batch_damage);
+    icon_view->priv->batch_damage = NULL;
+}
+
 void
 xfdesktop_icon_view_remove_item(XfdesktopIconView *icon_view,
                                 XfdesktopIcon *icon)
@@ -3857,14 +4632,17 @@ xfdesktop_icon_view_remove_item(XfdesktopIconView *icon_view,
         g_signal_handlers_disconnect_by_func(G_OBJECT(icon),
                                              G_CALLBACK(xfdesktop_icon_view_icon_changed),
                                              icon_view);
+        xfdesktop_icon_view_cell_cache_remove(icon_view, icon);
+        g_hash_table_remove(icon_view->priv->label_metrics, icon);
+        g_hash_table_remove(icon_view->priv->state_pixbufs, icon);
+        g_hash_table_remove(icon_view->priv->overflow_icons, icon);
         
         if(xfdesktop_icon_get_position(icon, &row, &col)) {
             xfdesktop_icon_view_invalidate_icon(icon_view, icon, FALSE);
             xfdesktop_grid_set_position_free(icon_view, row, col);
         }
         icon_view->priv->icons = g_list_delete_link(icon_view->priv->icons, l);
-        icon_view->priv->selected_icons = g_list_remove(icon_view->priv->selected_icons,
-                                                        icon);
+        xfdesktop_icon_view_selection_remove(icon_view, icon);
         if(icon_view->priv->cursor == icon) {
             icon_view->priv->cursor = NULL;
             if(icon_view->priv->selected_icons)
@@ -3926,10 +4704,12 @@ xfdesktop_icon_view_remove_all(XfdesktopIconView *icon_view)
         icon_view->priv->icons = NULL;
     }
     
-    if(icon_view->priv->selected_icons) {
-        g_list_free(icon_view->priv->selected_icons);
-        icon_view->priv->selected_icons = NULL;
-    }
+    xfdesktop_icon_view_selection_clear(icon_view);
+
+    xfdesktop_icon_view_cell_cache_flush(icon_view);
+    xfdesktop_icon_view_label_metrics_flush(icon_view);
+    g_hash_table_remove_all(icon_view->priv->state_pixbufs);
+    g_hash_table_remove_all(icon_view->priv->overflow_icons);
     
     icon_view->priv->item_under_pointer = NULL;
     icon_view->priv->cursor = NULL;
@@ -3956,15 +4736,19 @@ xfdesktop_icon_view_set_selection_mode(XfdesktopIconView *icon_view,
             icon_view->priv->sel_mode = GTK_SELECTION_SINGLE;
             /* fall through */
         case GTK_SELECTION_SINGLE:
-            if(g_list_length(icon_view->priv->selected_icons) > 1) {
-                GList *l;
-                /* TODO: enable later and make sure it works */
-                /*gdk_window_freeze_updates(GTK_WIDGET(icon_view)->window);*/
-                for(l = icon_view->priv->selected_icons->next; l; l = l->next) {
-                    xfdesktop_icon_view_unselect_item(icon_view,
-                                                      XFDESKTOP_ICON(l->data));
+            if(icon_view->priv->selected_icons
+               && icon_view->priv->selected_icons->next)
+            {
+                GdkRegion *damage = gdk_region_new();
+
+                /* keep only the most recently selected icon */
+                while(icon_view->priv->selected_icons->next) {
+                    XfdesktopIcon *icon = icon_view->priv->selected_icons->next->data;
+                    xfdesktop_icon_view_selection_remove(icon_view, icon);
+                    xfdesktop_icon_view_damage_icon(icon_view, icon, damage);
                 }
-                /*gdk_window_thaw_updates(GTK_WIDGET(icon_view)->window);*/
+
+                xfdesktop_icon_view_selection_changed(icon_view, damage);
             }
             icon_view->priv->allow_rubber_banding = FALSE;
             break;
@@ -4125,8 +4909,7 @@ xfdesktop_icon_view_select_item(XfdesktopIconView *icon_view,
     if(icon_view->priv->sel_mode == GTK_SELECTION_SINGLE)
         xfdesktop_icon_view_unselect_all(icon_view);
     
-    icon_view->priv->selected_icons = g_list_prepend(icon_view->priv->selected_icons,
-                                                     icon);
+    xfdesktop_icon_view_selection_add(icon_view, icon);
     xfdesktop_icon_view_invalidate_icon(icon_view, icon, TRUE);
     
     g_signal_emit(G_OBJECT(icon_view),
@@ -4138,50 +4921,215 @@ xfdesktop_icon_view_select_item(XfdesktopIconView *icon_view,
 void
 xfdesktop_icon_view_select_all(XfdesktopIconView *icon_view)
 {
+    GdkRegion *damage;
     GList *l;
+    gboolean changed = FALSE;
 
     g_return_if_fail(XFDESKTOP_IS_ICON_VIEW(icon_view));
 
-    if(!icon_view->priv->icons)
+    if(icon_view->priv->sel_mode != GTK_SELECTION_MULTIPLE)
+        return;
+
+    damage = gdk_region_new();
+
+    for(l = icon_view->priv->icons; l; l = l->next) {
+        if(xfdesktop_icon_view_selection_add(icon_view, l->data)) {
+            xfdesktop_icon_view_damage_icon(icon_view, l->data, damage);
+            xfdesktop_icon_selected(l->data);
+            changed = TRUE;
+        }
+    }
+
+    if(changed)
+        xfdesktop_icon_view_selection_changed(icon_view, damage);
+    else
+        gdk_region_destroy(damage);
+}
+
+/* selects every icon from @start_icon to @end_icon inclusive, in row-major
+ * grid order */
+void
+xfdesktop_icon_view_select_range(XfdesktopIconView *icon_view,
+                                 XfdesktopIcon *start_icon,
+                                 XfdesktopIcon *end_icon)
+{
+    guint16 start_row, start_col, end_row, end_col;
+    gint i, j;
+    XfdesktopIcon *icon;
+    GdkRegion *damage;
+    gboolean changed = FALSE;
+
+    g_return_if_fail(XFDESKTOP_IS_ICON_VIEW(icon_view)
+                     && XFDESKTOP_IS_ICON(start_icon)
+                     && XFDESKTOP_IS_ICON(end_icon));
+
+    if(icon_view->priv->sel_mode == GTK_SELECTION_SINGLE) {
+        xfdesktop_icon_view_select_item(icon_view, end_icon);
         return;
+    }
 
-    if(icon_view->priv->selected_icons
-       && g_list_length(icon_view->priv->icons)
-          == g_list_length(icon_view->priv->selected_icons))
+    if(!xfdesktop_icon_get_position(start_icon, &start_row, &start_col)
+       || !xfdesktop_icon_get_position(end_icon, &end_row, &end_col))
     {
         return;
     }
 
-    /* simplify: just free the entire list and repopulate it */
-    if(icon_view->priv->selected_icons) {
-        g_list_free(icon_view->priv->selected_icons);
-        icon_view->priv->selected_icons = NULL;
+    if(start_row > end_row || (start_row == end_row && start_col > end_col)) {
+        /* flip start and end */
+        guint16 tmpr = start_row, tmpc = start_col;
+
+        start_row = end_row;
+        start_col = end_col;
+        end_row = tmpr;
+        end_col = tmpc;
+    }
+
+    damage = gdk_region_new();
+
+    for(i = start_row; i <= end_row; ++i) {
+        for(j = (i == start_row ? start_col : 0);
+            (i == end_row ? j <= end_col : j < icon_view->priv->ncols);
+            ++j)
+        {
+            icon = xfdesktop_icon_view_icon_in_cell(icon_view, i, j);
+            if(icon && xfdesktop_icon_view_selection_add(icon_view, icon)) {
+                xfdesktop_icon_view_damage_icon(icon_view, icon, damage);
+                xfdesktop_icon_selected(icon);
+                changed = TRUE;
+            }
+        }
+    }
+
+    if(changed)
+        xfdesktop_icon_view_selection_changed(icon_view, damage);
+    else
+        gdk_region_destroy(damage);
+}
+
+/* selects every icon whose extents intersect @rect, which is in widget
+ * coordinates.  if @extend is FALSE, everything else is unselected. */
+void
+xfdesktop_icon_view_select_rect(XfdesktopIconView *icon_view,
+                                GdkRectangle *rect,
+                                gboolean extend)
+{
+    GdkRegion *damage;
+    GList *l, *next;
+    GHashTable *in_rect;
+    gint row, col, first_row, last_row, first_col, last_col;
+    GdkRectangle extents, dummy;
+    gboolean changed = FALSE;
+
+    g_return_if_fail(XFDESKTOP_IS_ICON_VIEW(icon_view) && rect);
+
+    /* like rubber banding, this only makes sense with multiple selection */
+    if(!icon_view->priv->grid_layout
+       || icon_view->priv->sel_mode != GTK_SELECTION_MULTIPLE)
+    {
+        return;
+    }
+
+    in_rect = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    /* anything intersecting @rect either lives in a cell that does, or
+     * overflows its own cell */
+    if(!xfdesktop_icon_view_rect_to_cells(icon_view, rect, FALSE,
+                                          &first_row, &last_row,
+                                          &first_col, &last_col))
+    {
+        first_row = first_col = 0;
+        last_row = last_col = -1;
+    }
+
+    for(col = first_col; col <= last_col; ++col) {
+        for(row = first_row; row <= last_row; ++row) {
+            XfdesktopIcon *icon = xfdesktop_icon_view_icon_in_cell(icon_view,
+                                                                   row, col);
+            if(icon
+               && xfdesktop_icon_get_extents(icon, NULL, NULL, &extents)
+               && gdk_rectangle_intersect(&extents, rect, &dummy))
+            {
+                g_hash_table_insert(in_rect, icon, icon);
+            }
+        }
+    }
+
+    l = g_hash_table_get_keys(icon_view->priv->overflow_icons);
+    for(; l; l = g_list_delete_link(l, l)) {
+        if(xfdesktop_icon_get_extents(l->data, NULL, NULL, &extents)
+           && gdk_rectangle_intersect(&extents, rect, &dummy))
+        {
+            g_hash_table_insert(in_rect, l->data, l->data);
+        }
+    }
+
+    damage = gdk_region_new();
+
+    if(!extend) {
+        for(l = icon_view->priv->selected_icons; l; l = next) {
+            XfdesktopIcon *icon = l->data;
+
+            next = l->next;
+            if(!g_hash_table_lookup(in_rect, icon)) {
+                xfdesktop_icon_view_selection_remove(icon_view, icon);
+                xfdesktop_icon_view_damage_icon(icon_view, icon, damage);
+                changed = TRUE;
+            }
+        }
+    }
+
+    l = g_hash_table_get_keys(in_rect);
+    for(; l; l = g_list_delete_link(l, l)) {
+        if(xfdesktop_icon_view_selection_add(icon_view, l->data)) {
+            xfdesktop_icon_view_damage_icon(icon_view, l->data, damage);
+            xfdesktop_icon_selected(l->data);
+            changed = TRUE;
+        }
     }
 
+    g_hash_table_destroy(in_rect);
+
+    if(changed)
+        xfdesktop_icon_view_selection_changed(icon_view, damage);
+    else
+        gdk_region_destroy(damage);
+}
+
+void
+xfdesktop_icon_view_invert_selection(XfdesktopIconView *icon_view)
+{
+    GdkRegion *damage;
+    GList *l;
+
+    g_return_if_fail(XFDESKTOP_IS_ICON_VIEW(icon_view));
+
+    if(!icon_view->priv->icons
+       || icon_view->priv->sel_mode != GTK_SELECTION_MULTIPLE)
+    {
+        return;
+    }
+
+    damage = gdk_region_new();
+
     for(l = icon_view->priv->icons; l; l = l->next) {
-        icon_view->priv->selected_icons = g_list_prepend(icon_view->priv->selected_icons, l->data);
-        xfdesktop_icon_view_invalidate_icon(icon_view, l->data, TRUE);
-        xfdesktop_icon_selected(l->data);
+        if(!xfdesktop_icon_view_selection_remove(icon_view, l->data)) {
+            xfdesktop_icon_view_selection_add(icon_view, l->data);
+            xfdesktop_icon_selected(l->data);
+        }
+        xfdesktop_icon_view_damage_icon(icon_view, l->data, damage);
     }
 
-    g_signal_emit(G_OBJECT(icon_view),
-                  __signals[SIG_ICON_SELECTION_CHANGED],
-                  0, NULL);
+    xfdesktop_icon_view_selection_changed(icon_view, damage);
 }
 
 void
 xfdesktop_icon_view_unselect_item(XfdesktopIconView *icon_view,
                                   XfdesktopIcon *icon)
 {
-    GList *l;
-
     g_return_if_fail(XFDESKTOP_IS_ICON_VIEW(icon_view)
                      && XFDESKTOP_IS_ICON(icon));
     
-    l = g_list_find(icon_view->priv->selected_icons, icon);
-    if(l) {
-        icon_view->priv->selected_icons = g_list_delete_link(icon_view->priv->selected_icons,
-                                                             l);
+    if(xfdesktop_icon_view_selection_remove(icon_view, icon)) {
         xfdesktop_icon_view_invalidate_icon(icon_view, icon, TRUE);
         g_signal_emit(G_OBJECT(icon_view),
                       __signals[SIG_ICON_SELECTION_CHANGED],
@@ -4192,18 +5140,25 @@ xfdesktop_icon_view_unselect_item(XfdesktopIconView *icon_view,
 void
 xfdesktop_icon_view_unselect_all(XfdesktopIconView *icon_view)
 {
+    GdkRegion *damage;
+    GList *repaint_icons, *l;
+
     g_return_if_fail(XFDESKTOP_IS_ICON_VIEW(icon_view));
     
-    if(icon_view->priv->selected_icons) {
-        GList *repaint_icons = icon_view->priv->selected_icons;
-        icon_view->priv->selected_icons = NULL;
-        g_list_foreach(repaint_icons, xfdesktop_list_foreach_invalidate,
-                       icon_view);
-        g_list_free(repaint_icons);
-        g_signal_emit(G_OBJECT(icon_view),
-                      __signals[SIG_ICON_SELECTION_CHANGED],
-                      0, NULL);
-    }
+    if(!icon_view->priv->selected_icons)
+        return;
+
+    /* the icons must be unselected before their extents are recalculated */
+    repaint_icons = icon_view->priv->selected_icons;
+    icon_view->priv->selected_icons = NULL;
+    g_hash_table_remove_all(icon_view->priv->selected_set);
+
+    damage = gdk_region_new();
+    for(l = repaint_icons; l; l = l->next)
+        xfdesktop_icon_view_damage_icon(icon_view, l->data, damage);
+    g_list_free(repaint_icons);
+
+    xfdesktop_icon_view_selection_changed(icon_view, damage);
 }
 
 void
@@ -4216,6 +5171,9 @@ xfdesktop_icon_view_set_icon_size(XfdesktopIconView *icon_view,
         return;
     
     icon_view->priv->icon_size = icon_size;
+    xfdesktop_icon_view_cell_cache_flush(icon_view);
+    g_hash_table_remove_all(icon_view->priv->state_pixbufs);
+    xfdesktop_icon_view_label_metrics_flush(icon_view);
     
     if(gtk_widget_get_realized(GTK_WIDGET(icon_view))) {
         xfdesktop_grid_do_resize(icon_view);
@@ -4240,6 +5198,8 @@ xfdesktop_icon_view_set_font_size(XfdesktopIconView *icon_view,
         return;
     
     icon_view->priv->font_size = font_size_points;
+    xfdesktop_icon_view_cell_cache_flush(icon_view);
+    xfdesktop_icon_view_label_metrics_flush(icon_view);
     
     if(gtk_widget_get_realized(GTK_WIDGET(icon_view))) {
         xfdesktop_icon_view_modify_font_size(icon_view, font_size_points);
@@ -74,6 +74,10 @@ GtkWidget *xfdesktop_icon_view_new(XfdesktopIconViewManager *manager);
 
 void xfdesktop_icon_view_add_item(XfdesktopIconView *icon_view,
                                   XfdesktopIcon *icon);
+void xfdesktop_icon_view_add_items(XfdesktopIconView *icon_view,
+                                   GList *icons);
+void xfdesktop_icon_view_begin_batch(XfdesktopIconView *icon_view);
+void xfdesktop_icon_view_end_batch(XfdesktopIconView *icon_view);
 
 void xfdesktop_icon_view_remove_item(XfdesktopIconView *icon_view,
                                      XfdesktopIcon *icon);
@@ -104,6 +108,13 @@ GList *xfdesktop_icon_view_get_selected_items(XfdesktopIconView *icon_view);
 void xfdesktop_icon_view_select_item(XfdesktopIconView *icon_view,
                                      XfdesktopIcon *icon);
 void xfdesktop_icon_view_select_all(XfdesktopIconView *icon_view);
+void xfdesktop_icon_view_select_range(XfdesktopIconView *icon_view,
+                                      XfdesktopIcon *start_icon,
+                                      XfdesktopIcon *end_icon);
+void xfdesktop_icon_view_select_rect(XfdesktopIconView *icon_view,
+                                     GdkRectangle *rect,
+                                     gboolean extend);
+void xfdesktop_icon_view_invert_selection(XfdesktopIconView *icon_view);
 void xfdesktop_icon_view_unselect_item(XfdesktopIconView *icon_view,
                                        XfdesktopIcon *icon);
 void xfdesktop_icon_view_unselect_all(XfdesktopIconView *icon_view);
@@ -192,6 +192,21 @@ xfdesktop_icon_get_extents(XfdesktopIcon *icon,
     return TRUE;
 }
 
+/*< optional; called by the icon view right before it paints the icon, so
+ * icons that load their pixbuf in the background can hurry up >*/
+void
+xfdesktop_icon_exposed(XfdesktopIcon *icon)
+{
+    XfdesktopIconClass *klass;
+
+    g_return_if_fail(XFDESKTOP_IS_ICON(icon));
+
+    klass = XFDESKTOP_ICON_GET_CLASS(icon);
+
+    if(klass->exposed)
+        klass->exposed(icon);
+}
+
 /*< required >*/
 GdkPixbuf *
 xfdesktop_icon_peek_pixbuf(XfdesktopIcon *icon,
@@ -81,6 +81,8 @@ struct _XfdesktopIconClass
 
     gboolean (*populate_context_menu)(XfdesktopIcon *icon,
                                       GtkWidget *menu);
+
+    void (*exposed)(XfdesktopIcon *icon);
 };
 
 GType xfdesktop_icon_get_type(void) G_GNUC_CONST;
@@ -144,6 +146,7 @@ gboolean xfdesktop_icon_get_extents(XfdesktopIcon *icon,
                                     GdkRectangle *pixbuf_extents,
                                     GdkRectangle *text_extents,
                                     GdkRectangle *total_extents);
+void xfdesktop_icon_exposed(XfdesktopIcon *icon);
 
 G_END_DECLS
 
@@ -0,0 +1,326 @@
+/*
+ *  xfdesktop - xfce4's desktop manager
+ *
+ *  Copyright (c) 2014 The Xfce Development Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software Foundation,
+ *  Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+
+/* the vector paths treat an RGBA pixel as one little-endian 32-bit word */
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_PIXBUF_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAVE_PIXBUF_NEON 1
+#endif
+#endif
+
+#include "xfdesktop-pixbuf-utils.h"
+
+/* (x * LUCENT_DIV100_MUL) >> LUCENT_DIV100_SHIFT == x / 100 for every
+ * x in [0, 255 * 100], which is all an alpha * percent product can be */
+#define LUCENT_DIV100_MUL    41944
+#define LUCENT_DIV100_SHIFT  22
+
+
+static inline guchar
+xfdesktop_pixbuf_lighten(guchar value)
+{
+    gint new_value = value + 24 + (value >> 3);
+
+    return new_value > 255 ? 255 : new_value;
+}
+
+static GdkPixbuf *
+xfdesktop_pixbuf_new_like(const GdkPixbuf *src,
+                          gboolean has_alpha)
+{
+    return gdk_pixbuf_new(gdk_pixbuf_get_colorspace(src), has_alpha,
+                          gdk_pixbuf_get_bits_per_sample(src),
+                          gdk_pixbuf_get_width(src),
+                          gdk_pixbuf_get_height(src));
+}
+
+static void
+xfdesktop_pixbuf_colorize_row(const guchar *src,
+                              guchar *dst,
+                              gint width,
+                              gint n_channels,
+                              guint r,
+                              guint g,
+                              guint b)
+{
+    gint i = 0;
+
+#if defined(HAVE_PIXBUF_SSE2)
+    if(n_channels == 4) {
+        /* alpha gets a factor of 256, so the final >> 8 leaves it as-is */
+        const __m128i factor = _mm_set_epi16(256, b, g, r, 256, b, g, r);
+        const __m128i zero = _mm_setzero_si128();
+
+        for(; i + 4 <= width; i += 4) {
+            __m128i px = _mm_loadu_si128((const __m128i *)(src + i * 4));
+            __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(px, zero), factor);
+            __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(px, zero), factor);
+
+            lo = _mm_srli_epi16(lo, 8);
+            hi = _mm_srli_epi16(hi, 8);
+            _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_packus_epi16(lo, hi));
+        }
+    }
+#elif defined(HAVE_PIXBUF_NEON)
+    if(n_channels == 4) {
+        const uint16x8_t fr = vdupq_n_u16(r), fg = vdupq_n_u16(g), fb = vdupq_n_u16(b);
+
+        for(; i + 16 <= width; i += 16) {
+            uint8x16x4_t px = vld4q_u8(src + i * 4);
+
+#define NEON_SCALE(v, f) \
+            vcombine_u8(vshrn_n_u16(vmulq_u16(vmovl_u8(vget_low_u8(v)), f), 8), \
+                        vshrn_n_u16(vmulq_u16(vmovl_u8(vget_high_u8(v)), f), 8))
+            px.val[0] = NEON_SCALE(px.val[0], fr);
+            px.val[1] = NEON_SCALE(px.val[1], fg);
+            px.val[2] = NEON_SCALE(px.val[2], fb);
+#undef NEON_SCALE
+
+            vst4q_u8(dst + i * 4, px);
+        }
+    }
+#endif
+
+    src += i * n_channels;
+    dst += i * n_channels;
+    for(; i < width; ++i) {
+        *dst++ = (*src++ * r) >> 8;
+        *dst++ = (*src++ * g) >> 8;
+        *dst++ = (*src++ * b) >> 8;
+        if(n_channels == 4)
+            *dst++ = *src++;
+    }
+}
+
+static void
+xfdesktop_pixbuf_spotlight_row(const guchar *src,
+                               guchar *dst,
+                               gint width,
+                               gint n_channels)
+{
+    gint i = 0;
+
+#if defined(HAVE_PIXBUF_SSE2)
+    if(n_channels == 4) {
+        const __m128i bias = _mm_set1_epi8(24);
+        const __m128i low5 = _mm_set1_epi8(0x1f);
+        const __m128i alpha_mask = _mm_set1_epi32((gint)0xff000000);
+
+        for(; i + 4 <= width; i += 4) {
+            __m128i px = _mm_loadu_si128((const __m128i *)(src + i * 4));
+            /* per-byte value >> 3; there's no 8-bit shift in SSE2 */
+            __m128i eighth = _mm_and_si128(_mm_srli_epi16(px, 3), low5);
+            __m128i lit = _mm_adds_epu8(px, _mm_add_epi8(eighth, bias));
+
+            lit = _mm_or_si128(_mm_and_si128(alpha_mask, px),
+                               _mm_andnot_si128(alpha_mask, lit));
+            _mm_storeu_si128((__m128i *)(dst + i * 4), lit);
+        }
+    }
+#elif defined(HAVE_PIXBUF_NEON)
+    if(n_channels == 4) {
+        const uint8x16_t bias = vdupq_n_u8(24);
+
+        for(; i + 16 <= width; i += 16) {
+            uint8x16x4_t px = vld4q_u8(src + i * 4);
+            gint c;
+
+            for(c = 0; c < 3; ++c) {
+                px.val[c] = vqaddq_u8(px.val[c],
+                                      vaddq_u8(vshrq_n_u8(px.val[c], 3), bias));
+            }
+
+            vst4q_u8(dst + i * 4, px);
+        }
+    }
+#endif
+
+    src += i * n_channels;
+    dst += i * n_channels;
+    for(; i < width; ++i) {
+        *dst++ = xfdesktop_pixbuf_lighten(*src++);
+        *dst++ = xfdesktop_pixbuf_lighten(*src++);
+        *dst++ = xfdesktop_pixbuf_lighten(*src++);
+        if(n_channels == 4)
+            *dst++ = *src++;
+    }
+}
+
+/* @dst always has an alpha channel */
+static void
+xfdesktop_pixbuf_lucent_row(const guchar *src,
+                            guchar *dst,
+                            gint width,
+                            gint n_channels,
+                            guint percent)
+{
+    gint i = 0;
+
+#if defined(HAVE_PIXBUF_SSE2)
+    if(n_channels == 4) {
+        const __m128i rgb_mask = _mm_set1_epi32(0x00ffffff);
+        const __m128i pct = _mm_set1_epi32(percent);
+        const __m128i div = _mm_set1_epi32(LUCENT_DIV100_MUL);
+
+        for(; i + 4 <= width; i += 4) {
+            __m128i px = _mm_loadu_si128((const __m128i *)(src + i * 4));
+            /* alpha ends up in the low 16 bits of each 32-bit lane, with
+             * the high 16 bits zero, so 16-bit arithmetic is exact */
+            __m128i a = _mm_mullo_epi16(_mm_srli_epi32(px, 24), pct);
+
+            a = _mm_mulhi_epu16(a, div);
+            a = _mm_srli_epi16(a, LUCENT_DIV100_SHIFT - 16);
+            px = _mm_or_si128(_mm_and_si128(px, rgb_mask),
+                              _mm_slli_epi32(a, 24));
+            _mm_storeu_si128((__m128i *)(dst + i * 4), px);
+        }
+    }
+#elif defined(HAVE_PIXBUF_NEON)
+    if(n_channels == 4) {
+        const uint8x8_t pct = vdup_n_u8(percent);
+        const uint16x4_t div = vdup_n_u16(LUCENT_DIV100_MUL);
+
+        for(; i + 16 <= width; i += 16) {
+            uint8x16x4_t px = vld4q_u8(src + i * 4);
+            uint16x8_t lo = vmull_u8(vget_low_u8(px.val[3]), pct);
+            uint16x8_t hi = vmull_u8(vget_high_u8(px.val[3]), pct);
+
+#define NEON_DIV100(v) \
+            vcombine_u16(vmovn_u32(vshrq_n_u32(vmull_u16(vget_low_u16(v), div), LUCENT_DIV100_SHIFT)), \
+                         vmovn_u32(vshrq_n_u32(vmull_u16(vget_high_u16(v), div), LUCENT_DIV100_SHIFT)))
+            px.val[3] = vcombine_u8(vmovn_u16(NEON_DIV100(lo)),
+                                    vmovn_u16(NEON_DIV100(hi)));
+#undef NEON_DIV100
+
+            vst4q_u8(dst + i * 4, px);
+        }
+    }
+#endif
+
+    src += i * n_channels;
+    dst += i * 4;
+    for(; i < width; ++i) {
+        *dst++ = *src++;
+        *dst++ = *src++;
+        *dst++ = *src++;
+        *dst++ = ((n_channels == 4 ? *src++ : 255) * percent) / 100;
+    }
+}
+
+GdkPixbuf *
+xfdesktop_pixbuf_colorize(const GdkPixbuf *src,
+                          const GdkColor *color)
+{
+    GdkPixbuf *dst;
+    const guchar *src_pixels;
+    guchar *dst_pixels;
+    gint width, height, n_channels, src_stride, dst_stride, y;
+
+    g_return_val_if_fail(GDK_IS_PIXBUF(src) && color, NULL);
+
+    dst = xfdesktop_pixbuf_new_like(src, gdk_pixbuf_get_has_alpha(src));
+    width = gdk_pixbuf_get_width(src);
+    height = gdk_pixbuf_get_height(src);
+    n_channels = gdk_pixbuf_get_n_channels(src);
+    src_pixels = gdk_pixbuf_get_pixels(src);
+    src_stride = gdk_pixbuf_get_rowstride(src);
+    dst_pixels = gdk_pixbuf_get_pixels(dst);
+    dst_stride = gdk_pixbuf_get_rowstride(dst);
+
+    for(y = 0; y < height; ++y) {
+        xfdesktop_pixbuf_colorize_row(src_pixels + y * src_stride,
+                                      dst_pixels + y * dst_stride,
+                                      width, n_channels,
+                                      color->red / 255,
+                                      color->green / 255,
+                                      color->blue / 255);
+    }
+
+    return dst;
+}
+
+GdkPixbuf *
+xfdesktop_pixbuf_spotlight(const GdkPixbuf *src)
+{
+    GdkPixbuf *dst;
+    const guchar *src_pixels;
+    guchar *dst_pixels;
+    gint width, height, n_channels, src_stride, dst_stride, y;
+
+    g_return_val_if_fail(GDK_IS_PIXBUF(src), NULL);
+
+    dst = xfdesktop_pixbuf_new_like(src, gdk_pixbuf_get_has_alpha(src));
+    width = gdk_pixbuf_get_width(src);
+    height = gdk_pixbuf_get_height(src);
+    n_channels = gdk_pixbuf_get_n_channels(src);
+    src_pixels = gdk_pixbuf_get_pixels(src);
+    src_stride = gdk_pixbuf_get_rowstride(src);
+    dst_pixels = gdk_pixbuf_get_pixels(dst);
+    dst_stride = gdk_pixbuf_get_rowstride(dst);
+
+    for(y = 0; y < height; ++y) {
+        xfdesktop_pixbuf_spotlight_row(src_pixels + y * src_stride,
+                                       dst_pixels + y * dst_stride,
+                                       width, n_channels);
+    }
+
+    return dst;
+}
+
+GdkPixbuf *
+xfdesktop_pixbuf_lucent(const GdkPixbuf *src,
+                        guint percent)
+{
+    GdkPixbuf *dst;
+    const guchar *src_pixels;
+    guchar *dst_pixels;
+    gint width, height, n_channels, src_stride, dst_stride, y;
+
+    g_return_val_if_fail(GDK_IS_PIXBUF(src), NULL);
+
+    percent = MIN(percent, 100);
+
+    dst = xfdesktop_pixbuf_new_like(src, TRUE);
+    width = gdk_pixbuf_get_width(src);
+    height = gdk_pixbuf_get_height(src);
+    n_channels = gdk_pixbuf_get_n_channels(src);
+    src_pixels = gdk_pixbuf_get_pixels(src);
+    src_stride = gdk_pixbuf_get_rowstride(src);
+    dst_pixels = gdk_pixbuf_get_pixels(dst);
+    dst_stride = gdk_pixbuf_get_rowstride(dst);
+
+    for(y = 0; y < height; ++y) {
+        xfdesktop_pixbuf_lucent_row(src_pixels + y * src_stride,
+                                    dst_pixels + y * dst_stride,
+                                    width, n_channels, percent);
+    }
+
+    return dst;
+}
@@ -0,0 +1,41 @@
+/*
+ *  xfdesktop - xfce4's desktop manager
+ *
+ *  Copyright (c) 2014 The Xfce Development Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software Foundation,
+ *  Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __XFDESKTOP_PIXBUF_UTILS_H__
+#define __XFDESKTOP_PIXBUF_UTILS_H__
+
+#include <gdk/gdk.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+/* drop-in replacements for exo_gdk_pixbuf_colorize(), _spotlight() and
+ * _lucent() that produce identical output, using SSE2 or NEON for RGBA
+ * pixbufs where available.  all of them return a new pixbuf. */
+
+GdkPixbuf *xfdesktop_pixbuf_colorize(const GdkPixbuf *src,
+                                     const GdkColor *color);
+GdkPixbuf *xfdesktop_pixbuf_spotlight(const GdkPixbuf *src);
+GdkPixbuf *xfdesktop_pixbuf_lucent(const GdkPixbuf *src,
+                                   guint percent);
+
+G_END_DECLS
+
+#endif  /* __XFDESKTOP_PIXBUF_UTILS_H__ */
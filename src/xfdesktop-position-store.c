@@ -0,0 +1,736 @@
+/*
+ *  xfdesktop - xfce4's desktop manager
+ *
+ *  Copyright (c) 2014 The Xfce Development Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software Foundation,
+ *  Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/* File layout, all under $XDG_CONFIG_HOME/xfce4/desktop/:
+ *
+ *  icons.screenN.positions - the snapshot: a "[WxH]" line starts the
+ *    section for a resolution, followed by "name<TAB>row<TAB>col" lines.
+ *    a section is written even when it's empty, as a record that the old
+ *    rc file for that resolution has been imported.  the snapshot is only
+ *    ever replaced as a whole.
+ *
+ *  icons.screenN.journal - one "WxH<TAB>name<TAB>row<TAB>col<TAB>sum" line
+ *    per change since the snapshot was written, where sum is a checksum of
+ *    everything before it.  records that fail the checksum (e.g. a write
+ *    cut short by a crash) are skipped.  later records win.  a record with
+ *    a row of -1 and "*" for the section says the name was forgotten in
+ *    every section.
+ *
+ * Names are escaped with g_strescape(), so they never contain a tab or a
+ * newline.  in the snapshot, a leading '#' or '[' is escaped too, so a name
+ * never looks like a comment or a section header. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+
+#include <stdlib.h>
+#include <fcntl.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <libxfce4util/libxfce4util.h>
+
+#include "xfdesktop-common.h"
+#include "xfdesktop-position-store.h"
+
+/* fold the journal into the snapshot once it gets this big */
+#define JOURNAL_COMPACT_SIZE  (64 * 1024)
+
+/* the section of a journal record that forgets a name everywhere */
+#define ALL_SECTIONS  "*"
+
+typedef struct
+{
+    gint16 row;
+    gint16 col;
+} XfdesktopPosition;
+
+struct _XfdesktopPositionStore
+{
+    gint screen;
+    gchar *snapshot_path;
+    gchar *journal_path;
+
+    /* the current section, and name -> XfdesktopPosition for it */
+    gchar *section;
+    GHashTable *positions;
+
+    /* names changed since the last flush, and those forgotten since */
+    GHashTable *dirty;
+    GHashTable *removed;
+
+    gsize journal_size;
+
+    guint n_loads;
+    guint n_records_written;
+    guint n_compactions;
+};
+
+
+static guint32
+xfdesktop_position_store_checksum(const gchar *data,
+                                  gsize len)
+{
+    /* FNV-1a; plenty to catch a torn or garbled line */
+    guint32 hash = 2166136261u;
+    gsize i;
+
+    for(i = 0; i < len; ++i) {
+        hash ^= (guchar)data[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static GHashTable *
+xfdesktop_position_store_new_table(void)
+{
+    return g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+}
+
+static void
+xfdesktop_position_store_table_set(GHashTable *table,
+                                   const gchar *name,
+                                   gint16 row,
+                                   gint16 col)
+{
+    XfdesktopPosition *position = g_new(XfdesktopPosition, 1);
+
+    position->row = row;
+    position->col = col;
+    g_hash_table_replace(table, g_strdup(name), position);
+}
+
+/* returns the table for @section in @sections, creating it if needed */
+static GHashTable *
+xfdesktop_position_store_get_table(GHashTable *sections,
+                                   const gchar *section)
+{
+    GHashTable *table = g_hash_table_lookup(sections, section);
+
+    if(!table) {
+        table = xfdesktop_position_store_new_table();
+        g_hash_table_insert(sections, g_strdup(section), table);
+    }
+
+    return table;
+}
+
+static void
+xfdesktop_position_store_read_snapshot(XfdesktopPositionStore *store,
+                                       const gchar *only_section,
+                                       GHashTable *sections)
+{
+    gchar *contents = NULL, *line, *next;
+    GHashTable *table = NULL;
+
+    if(!g_file_get_contents(store->snapshot_path, &contents, NULL, NULL))
+        return;
+
+    for(line = contents; line && *line; line = next) {
+        gchar **fields;
+
+        next = strchr(line, '\n');
+        if(next)
+            *next++ = '\0';
+
+        if(*line == '#')
+            continue;
+
+        /* entries always have tabs; older versions didn't escape a
+         * leading '[' in names, so don't take those for headers */
+        if(*line == '[' && !strchr(line, '\t')) {
+            gchar *end = strrchr(line, ']');
+
+            table = NULL;
+            if(end && end[1] == '\0') {
+                *end = '\0';
+                if(!only_section || !strcmp(line + 1, only_section))
+                    table = xfdesktop_position_store_get_table(sections, line + 1);
+            }
+            continue;
+        }
+
+        /* not a section we were asked for */
+        if(!table)
+            continue;
+
+        fields = g_strsplit(line, "\t", 3);
+        if(g_strv_length(fields) == 3) {
+            gchar *name = g_strcompress(fields[0]);
+            xfdesktop_position_store_table_set(table, name,
+                                               atoi(fields[1]),
+                                               atoi(fields[2]));
+            g_free(name);
+        }
+        g_strfreev(fields);
+    }
+
+    g_free(contents);
+}
+
+static void
+xfdesktop_position_store_read_journal(XfdesktopPositionStore *store,
+                                      const gchar *only_section,
+                                      GHashTable *sections)
+{
+    gchar *contents = NULL, *line, *next;
+    gsize length = 0;
+
+    store->journal_size = 0;
+
+    if(!g_file_get_contents(store->journal_path, &contents, &length, NULL))
+        return;
+
+    store->journal_size = length;
+
+    for(line = contents; line && *line; line = next) {
+        gchar *sum, *end = NULL, **fields;
+        guint32 checksum;
+
+        next = strchr(line, '\n');
+        if(!next) {
+            /* an unterminated last line is an interrupted append */
+            break;
+        }
+        *next++ = '\0';
+
+        sum = strrchr(line, '\t');
+        if(!sum)
+            continue;
+
+        checksum = strtoul(sum + 1, &end, 16);
+        if(!end || *end
+           || checksum != xfdesktop_position_store_checksum(line, sum - line))
+        {
+            DBG("skipping corrupt journal record");
+            continue;
+        }
+        *sum = '\0';
+
+        fields = g_strsplit(line, "\t", 4);
+        if(g_strv_length(fields) == 4 && !strcmp(fields[0], ALL_SECTIONS)) {
+            gchar *name = g_strcompress(fields[1]);
+            GHashTableIter iter;
+            gpointer table;
+
+            g_hash_table_iter_init(&iter, sections);
+            while(g_hash_table_iter_next(&iter, NULL, &table))
+                g_hash_table_remove(table, name);
+            g_free(name);
+        } else if(g_strv_length(fields) == 4
+                  && (!only_section || !strcmp(fields[0], only_section)))
+        {
+            gchar *name = g_strcompress(fields[1]);
+            GHashTable *table = xfdesktop_position_store_get_table(sections,
+                                                                   fields[0]);
+            xfdesktop_position_store_table_set(table, name,
+                                               atoi(fields[2]),
+                                               atoi(fields[3]));
+            g_free(name);
+        }
+        g_strfreev(fields);
+    }
+
+    g_free(contents);
+}
+
+/* like g_strescape(), but also escapes a leading '#' or '[' so the snapshot
+ * reader doesn't mistake the line for a comment or a section header.
+ * g_strcompress() reads it back. */
+static gchar *
+xfdesktop_position_store_escape_name(const gchar *name)
+{
+    gchar *escaped = g_strescape(name, NULL), *ret;
+
+    if(*escaped != '#' && *escaped != '[')
+        return escaped;
+
+    ret = g_strdup_printf("\\%03o%s", (guchar)*escaped, escaped + 1);
+    g_free(escaped);
+
+    return ret;
+}
+
+static void
+xfdesktop_position_store_write_section(gpointer key,
+                                       gpointer value,
+                                       gpointer user_data)
+{
+    GString *out = user_data;
+    GHashTableIter iter;
+    gpointer name, data;
+
+    g_string_append_printf(out, "[%s]\n", (const gchar *)key);
+
+    g_hash_table_iter_init(&iter, value);
+    while(g_hash_table_iter_next(&iter, &name, &data)) {
+        XfdesktopPosition *position = data;
+        gchar *escaped = xfdesktop_position_store_escape_name(name);
+
+        g_string_append_printf(out, "%s\t%d\t%d\n", escaped,
+                               position->row, position->col);
+        g_free(escaped);
+    }
+}
+
+/* rewrites the snapshot with everything in it and in the journal, plus the
+ * current section as we have it in memory, then starts a new journal */
+static gboolean
+xfdesktop_position_store_compact(XfdesktopPositionStore *store)
+{
+    GHashTable *sections, *current;
+    GHashTableIter iter;
+    gpointer name, data;
+    GString *out;
+    GError *error = NULL;
+    gboolean ret;
+
+    sections = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                     (GDestroyNotify)g_hash_table_destroy);
+    xfdesktop_position_store_read_snapshot(store, NULL, sections);
+    xfdesktop_position_store_read_journal(store, NULL, sections);
+
+    /* forgotten since the last flush */
+    g_hash_table_iter_init(&iter, store->removed);
+    while(g_hash_table_iter_next(&iter, &name, NULL)) {
+        GHashTableIter section_iter;
+
+        g_hash_table_iter_init(&section_iter, sections);
+        while(g_hash_table_iter_next(&section_iter, NULL, &data))
+            g_hash_table_remove(data, name);
+    }
+
+    if(store->section) {
+        current = xfdesktop_position_store_new_table();
+        g_hash_table_iter_init(&iter, store->positions);
+        while(g_hash_table_iter_next(&iter, &name, &data)) {
+            XfdesktopPosition *position = data;
+            xfdesktop_position_store_table_set(current, name,
+                                               position->row, position->col);
+        }
+        g_hash_table_replace(sections, g_strdup(store->section), current);
+    }
+
+    out = g_string_new("# xfdesktop icon positions\n");
+    g_hash_table_foreach(sections, xfdesktop_position_store_write_section, out);
+    g_hash_table_destroy(sections);
+
+    ret = g_file_set_contents(store->snapshot_path, out->str, out->len, &error);
+    g_string_free(out, TRUE);
+
+    if(!ret) {
+        g_warning("Unable to write icon positions to %s: %s",
+                  store->snapshot_path, error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+
+    /* everything in the journal is in the snapshot now */
+    if(g_unlink(store->journal_path) && errno != ENOENT) {
+        g_warning("Unable to remove %s: %s", store->journal_path,
+                  strerror(errno));
+    }
+    store->journal_size = 0;
+    g_hash_table_remove_all(store->dirty);
+    g_hash_table_remove_all(store->removed);
+    store->n_compactions++;
+
+    DBG("compacted icon positions (%u loads, %u records written, %u compactions)",
+        store->n_loads, store->n_records_written, store->n_compactions);
+
+    return TRUE;
+}
+
+
+XfdesktopPositionStore *
+xfdesktop_position_store_new(gint screen)
+{
+    XfdesktopPositionStore *store;
+    gchar *dir, *filename;
+
+    dir = xfce_resource_save_location(XFCE_RESOURCE_CONFIG, "xfce4/desktop/",
+                                      TRUE);
+    if(!dir) {
+        g_warning("Unable to determine location of icon position cache file.  " \
+                  "Icon positions will not be saved.");
+        return NULL;
+    }
+
+    store = g_slice_new0(XfdesktopPositionStore);
+    store->screen = screen;
+
+    filename = g_strdup_printf("icons.screen%d.positions", screen);
+    store->snapshot_path = g_build_filename(dir, filename, NULL);
+    g_free(filename);
+
+    filename = g_strdup_printf("icons.screen%d.journal", screen);
+    store->journal_path = g_build_filename(dir, filename, NULL);
+    g_free(filename);
+
+    g_free(dir);
+
+    store->positions = xfdesktop_position_store_new_table();
+    store->dirty = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    store->removed = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    return store;
+}
+
+void
+xfdesktop_position_store_free(XfdesktopPositionStore *store)
+{
+    if(!store)
+        return;
+
+    xfdesktop_position_store_flush(store);
+
+    g_hash_table_destroy(store->positions);
+    g_hash_table_destroy(store->dirty);
+    g_hash_table_destroy(store->removed);
+    g_free(store->section);
+    g_free(store->snapshot_path);
+    g_free(store->journal_path);
+    g_slice_free(XfdesktopPositionStore, store);
+}
+
+/* switches to the positions for the given resolution, loading only that
+ * section.  the first time the store sees it, the positions are imported
+ * from the old rc file for that resolution, if there is one. */
+void
+xfdesktop_position_store_set_section(XfdesktopPositionStore *store,
+                                     gint width,
+                                     gint height)
+{
+    gchar *section, relpath[PATH_MAX], *filename;
+    GHashTable *sections;
+    gpointer key, table;
+    gboolean known;
+
+    g_return_if_fail(store);
+
+    section = g_strdup_printf("%dx%d", width, height);
+    if(!g_strcmp0(section, store->section)) {
+        g_free(section);
+        return;
+    }
+
+    /* pending changes belong to the old section */
+    xfdesktop_position_store_flush(store);
+
+    g_free(store->section);
+    store->section = section;
+    g_hash_table_destroy(store->positions);
+
+    sections = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                     (GDestroyNotify)g_hash_table_destroy);
+    xfdesktop_position_store_read_snapshot(store, section, sections);
+    xfdesktop_position_store_read_journal(store, section, sections);
+
+    known = g_hash_table_lookup_extended(sections, section, &key, &table);
+    if(known) {
+        g_hash_table_steal(sections, section);
+        g_free(key);
+        store->positions = table;
+    } else
+        store->positions = xfdesktop_position_store_new_table();
+    g_hash_table_destroy(sections);
+
+    store->n_loads++;
+    DBG("loaded %u icon positions for %s", g_hash_table_size(store->positions),
+        section);
+
+    /* imported already, even if everything has been forgotten since */
+    if(known)
+        return;
+
+    g_snprintf(relpath, PATH_MAX, "xfce4/desktop/icons.screen%d-%dx%d.rc",
+               store->screen, width, height);
+    filename = xfce_resource_lookup(XFCE_RESOURCE_CONFIG, relpath);
+
+    /* Check if we have to migrate from the old file format */
+    if(filename == NULL) {
+        g_snprintf(relpath, PATH_MAX, "xfce4/desktop/icons.screen%d.rc",
+                   store->screen);
+        filename = xfce_resource_lookup(XFCE_RESOURCE_CONFIG, relpath);
+    }
+
+    if(filename) {
+        xfdesktop_position_store_import_rc(store, filename);
+        g_free(filename);
+    }
+
+    /* writes out the section, so the rc file isn't imported again */
+    xfdesktop_position_store_compact(store);
+}
+
+gboolean
+xfdesktop_position_store_lookup(XfdesktopPositionStore *store,
+                                const gchar *name,
+                                gint16 *row,
+                                gint16 *col)
+{
+    XfdesktopPosition *position;
+
+    g_return_val_if_fail(store && row && col, FALSE);
+
+    if(!name)
+        return FALSE;
+
+    position = g_hash_table_lookup(store->positions, name);
+    if(!position)
+        return FALSE;
+
+    *row = position->row;
+    *col = position->col;
+
+    return TRUE;
+}
+
+void
+xfdesktop_position_store_set(XfdesktopPositionStore *store,
+                             const gchar *name,
+                             gint16 row,
+                             gint16 col)
+{
+    XfdesktopPosition *position;
+
+    g_return_if_fail(store && name);
+
+    position = g_hash_table_lookup(store->positions, name);
+    if(position && position->row == row && position->col == col)
+        return;
+
+    xfdesktop_position_store_table_set(store->positions, name, row, col);
+    g_hash_table_replace(store->dirty, g_strdup(name), GINT_TO_POINTER(1));
+}
+
+/* forgets the position of @name in every section, e.g. because its file is
+ * gone and a new file with the same name shouldn't end up in its place */
+void
+xfdesktop_position_store_remove(XfdesktopPositionStore *store,
+                                const gchar *name)
+{
+    g_return_if_fail(store && name);
+
+    g_hash_table_remove(store->positions, name);
+    g_hash_table_remove(store->dirty, name);
+    g_hash_table_replace(store->removed, g_strdup(name), GINT_TO_POINTER(1));
+}
+
+/* appends everything changed since the last flush to the journal, with a
+ * single fsync(), or compacts if the journal has grown too large */
+gboolean
+xfdesktop_position_store_flush(XfdesktopPositionStore *store)
+{
+    GHashTableIter iter;
+    gpointer name;
+    GString *out;
+    gssize written = 0;
+    gint fd;
+
+    g_return_val_if_fail(store, FALSE);
+
+    if(!store->section
+       || (g_hash_table_size(store->dirty) == 0
+           && g_hash_table_size(store->removed) == 0))
+    {
+        return TRUE;
+    }
+
+    if(store->journal_size >= JOURNAL_COMPACT_SIZE)
+        return xfdesktop_position_store_compact(store);
+
+    out = g_string_new(NULL);
+
+    /* removals first: a name forgotten and then set again since the last
+     * flush is in both, and the set has to win */
+    g_hash_table_iter_init(&iter, store->removed);
+    while(g_hash_table_iter_next(&iter, &name, NULL)) {
+        gchar *escaped = g_strescape(name, NULL);
+        gsize start = out->len;
+
+        g_string_append_printf(out, "%s\t%s\t-1\t-1", ALL_SECTIONS, escaped);
+        g_string_append_printf(out, "\t%08x\n",
+                               xfdesktop_position_store_checksum(out->str + start,
+                                                                 out->len - start));
+        g_free(escaped);
+        store->n_records_written++;
+    }
+
+    g_hash_table_iter_init(&iter, store->dirty);
+    while(g_hash_table_iter_next(&iter, &name, NULL)) {
+        XfdesktopPosition *position = g_hash_table_lookup(store->positions, name);
+        gchar *escaped;
+        gsize start = out->len;
+
+        if(!position)
+            continue;
+
+        escaped = g_strescape(name, NULL);
+        g_string_append_printf(out, "%s\t%s\t%d\t%d", store->section, escaped,
+                               position->row, position->col);
+        g_string_append_printf(out, "\t%08x\n",
+                               xfdesktop_position_store_checksum(out->str + start,
+                                                                 out->len - start));
+        g_free(escaped);
+        store->n_records_written++;
+    }
+
+    fd = g_open(store->journal_path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if(fd < 0) {
+        g_warning("Unable to open %s: %s", store->journal_path,
+                  strerror(errno));
+        g_string_free(out, TRUE);
+        return FALSE;
+    }
+
+    while(written < (gssize)out->len) {
+        gssize ret = write(fd, out->str + written, out->len - written);
+        if(ret < 0) {
+            if(errno == EINTR)
+                continue;
+            g_warning("Unable to write to %s: %s", store->journal_path,
+                      strerror(errno));
+            break;
+        }
+        written += ret;
+    }
+
+    if(fsync(fd))
+        g_warning("Unable to sync %s: %s", store->journal_path, strerror(errno));
+    close(fd);
+
+    store->journal_size += written;
+
+    if(written < (gssize)out->len) {
+        g_string_free(out, TRUE);
+        return FALSE;
+    }
+
+    g_string_free(out, TRUE);
+    g_hash_table_remove_all(store->dirty);
+    g_hash_table_remove_all(store->removed);
+
+    return TRUE;
+}
+
+/* reads every group of an old-style icons.screenN[-WxH].rc file into the
+ * current section */
+gboolean
+xfdesktop_position_store_import_rc(XfdesktopPositionStore *store,
+                                   const gchar *filename)
+{
+    XfceRc *rcfile;
+    gchar **groups;
+    gint i;
+    gboolean ret = FALSE;
+
+    g_return_val_if_fail(store && filename, FALSE);
+
+    rcfile = xfce_rc_simple_open(filename, TRUE);
+    if(!rcfile)
+        return FALSE;
+
+    groups = xfce_rc_get_groups(rcfile);
+    for(i = 0; groups && groups[i]; ++i) {
+        gint row, col;
+
+        xfce_rc_set_group(rcfile, groups[i]);
+        row = xfce_rc_read_int_entry(rcfile, "row", -1);
+        col = xfce_rc_read_int_entry(rcfile, "col", -1);
+        if(row >= 0 && col >= 0) {
+            xfdesktop_position_store_set(store, groups[i], row, col);
+            ret = TRUE;
+        }
+    }
+
+    g_strfreev(groups);
+    xfce_rc_close(rcfile);
+
+    DBG("imported %u icon positions from %s",
+        g_hash_table_size(store->positions), filename);
+
+    return ret;
+}
+
+/* writes the current section out as an rc file that older versions of
+ * xfdesktop can read */
+gboolean
+xfdesktop_position_store_export_rc(XfdesktopPositionStore *store,
+                                   const gchar *filename)
+{
+    XfceRc *rcfile;
+    GHashTableIter iter;
+    gpointer name, data;
+    gchar *tmppath;
+
+    g_return_val_if_fail(store && filename, FALSE);
+
+    tmppath = g_strconcat(filename, ".new", NULL);
+
+    rcfile = xfce_rc_simple_open(tmppath, FALSE);
+    if(!rcfile) {
+        g_free(tmppath);
+        return FALSE;
+    }
+
+    xfce_rc_set_group(rcfile, XFDESKTOP_RC_VERSION_STAMP);
+    xfce_rc_write_bool_entry(rcfile, "4.10.3+", TRUE);
+
+    g_hash_table_iter_init(&iter, store->positions);
+    while(g_hash_table_iter_next(&iter, &name, &data)) {
+        XfdesktopPosition *position = data;
+
+        xfce_rc_set_group(rcfile, name);
+        xfce_rc_write_int_entry(rcfile, "row", position->row);
+        xfce_rc_write_int_entry(rcfile, "col", position->col);
+    }
+
+    xfce_rc_flush(rcfile);
+    xfce_rc_close(rcfile);
+
+    if(g_rename(tmppath, filename)) {
+        g_warning("Unable to rename temp file to %s: %s", filename,
+                  strerror(errno));
+        g_unlink(tmppath);
+        g_free(tmppath);
+        return FALSE;
+    }
+
+    g_free(tmppath);
+
+    return TRUE;
+}
@@ -0,0 +1,60 @@
+/*
+ *  xfdesktop - xfce4's desktop manager
+ *
+ *  Copyright (c) 2014 The Xfce Development Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software Foundation,
+ *  Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __XFDESKTOP_POSITION_STORE_H__
+#define __XFDESKTOP_POSITION_STORE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* saved desktop icon positions for one screen.  positions are kept per
+ * resolution ("section") in a snapshot file, and changes are appended to a
+ * journal that is folded back into the snapshot once it grows too large. */
+typedef struct _XfdesktopPositionStore XfdesktopPositionStore;
+
+XfdesktopPositionStore *xfdesktop_position_store_new(gint screen);
+void xfdesktop_position_store_free(XfdesktopPositionStore *store);
+
+void xfdesktop_position_store_set_section(XfdesktopPositionStore *store,
+                                          gint width,
+                                          gint height);
+
+gboolean xfdesktop_position_store_lookup(XfdesktopPositionStore *store,
+                                         const gchar *name,
+                                         gint16 *row,
+                                         gint16 *col);
+void xfdesktop_position_store_set(XfdesktopPositionStore *store,
+                                  const gchar *name,
+                                  gint16 row,
+                                  gint16 col);
+void xfdesktop_position_store_remove(XfdesktopPositionStore *store,
+                                     const gchar *name);
+
+gboolean xfdesktop_position_store_flush(XfdesktopPositionStore *store);
+
+gboolean xfdesktop_position_store_import_rc(XfdesktopPositionStore *store,
+                                            const gchar *filename);
+gboolean xfdesktop_position_store_export_rc(XfdesktopPositionStore *store,
+                                            const gchar *filename);
+
+G_END_DECLS
+
+#endif  /* __XFDESKTOP_POSITION_STORE_H__ */
@@ -52,6 +52,9 @@
 
 #include "xfdesktop-file-utils.h"
 #include "xfdesktop-common.h"
+#include "xfdesktop-desktop-entry.h"
+#include "xfdesktop-folder-cover.h"
+#include "xfdesktop-icon-loader.h"
 #include "xfdesktop-regular-file-icon.h"
 
 #define EMBLEM_SYMLINK  "emblem-symbolic-link"
@@ -66,19 +69,38 @@ struct _XfdesktopRegularFileIconPrivate
     GFileInfo *filesystem_info;
     GFile *file;
     GFile *thumbnail_file;
-    GFileMonitor *monitor;
     GdkScreen *gscreen;
     XfdesktopFileIconManager *fmanager;
     gboolean show_thumbnails;
+    gboolean cover_scan_pending;
+    gboolean watching_folder;
+
+    /* file and loadable icons are decoded in the background; this is the
+     * last one we asked for, and its pixbuf once it's in */
+    GIcon *loaded_icon;
+    gint loaded_width;
+    gint loaded_height;
+    GdkPixbuf *loaded_pix;
+    XfdesktopIconLoad *icon_load;
+    gboolean exposed;
 };
 
 static void xfdesktop_regular_file_icon_finalize(GObject *obj);
 
+static void cb_show_thumbnails_notify(GObject *gobject,
+                                      GParamSpec *pspec,
+                                      gpointer user_data);
+static void cb_folder_contents_changed(GFile *folder,
+                                       GFile *child,
+                                       GFileMonitorEvent event,
+                                       gpointer user_data);
+
 static void xfdesktop_regular_file_icon_set_thumbnail_file(XfdesktopIcon *icon, GFile *file);
 static void xfdesktop_regular_file_icon_delete_thumbnail_file(XfdesktopIcon *icon);
 
 static GdkPixbuf *xfdesktop_regular_file_icon_peek_pixbuf(XfdesktopIcon *icon,
                                                           gint width, gint height);
+static void xfdesktop_regular_file_icon_exposed(XfdesktopIcon *icon);
 static const gchar *xfdesktop_regular_file_icon_peek_label(XfdesktopIcon *icon);
 static gchar *xfdesktop_regular_file_icon_get_identifier(XfdesktopIcon *icon);
 static GdkPixbuf *xfdesktop_regular_file_icon_peek_tooltip_pixbuf(XfdesktopIcon *icon,
@@ -134,6 +156,7 @@ xfdesktop_regular_file_icon_class_init(XfdesktopRegularFileIconClass *klass)
     icon_class->do_drop_dest = xfdesktop_regular_file_icon_do_drop_dest;
     icon_class->set_thumbnail_file = xfdesktop_regular_file_icon_set_thumbnail_file;
     icon_class->delete_thumbnail_file = xfdesktop_regular_file_icon_delete_thumbnail_file;
+    icon_class->exposed = xfdesktop_regular_file_icon_exposed;
     
     file_icon_class->peek_file_info = xfdesktop_regular_file_icon_peek_file_info;
     file_icon_class->peek_filesystem_info = xfdesktop_regular_file_icon_peek_filesystem_info;
@@ -169,6 +192,19 @@ xfdesktop_regular_file_icon_finalize(GObject *obj)
     if(icon->priv->filesystem_info)
         g_object_unref(icon->priv->filesystem_info);
 
+    /* the manager clears fmanager if it goes away first */
+    if(icon->priv->watching_folder && icon->priv->fmanager) {
+        xfdesktop_file_icon_manager_unwatch_folder(icon->priv->fmanager,
+                                                   icon->priv->file,
+                                                   cb_folder_contents_changed,
+                                                   icon);
+        g_signal_handlers_disconnect_by_func(G_OBJECT(icon->priv->fmanager),
+                                             G_CALLBACK(cb_show_thumbnails_notify),
+                                             icon);
+        g_object_remove_weak_pointer(G_OBJECT(icon->priv->fmanager),
+                                     (gpointer *)&icon->priv->fmanager);
+    }
+
     g_object_unref(icon->priv->file);
     
     g_free(icon->priv->display_name);
@@ -179,8 +215,14 @@ xfdesktop_regular_file_icon_finalize(GObject *obj)
     if(icon->priv->thumbnail_file)
         g_object_unref(icon->priv->thumbnail_file);
 
-    if(icon->priv->monitor)
-        g_object_unref(icon->priv->monitor);
+    if(icon->priv->icon_load)
+        xfdesktop_icon_loader_cancel(icon->priv->icon_load);
+
+    if(icon->priv->loaded_icon)
+        g_object_unref(icon->priv->loaded_icon);
+
+    if(icon->priv->loaded_pix)
+        g_object_unref(icon->priv->loaded_pix);
 
     G_OBJECT_CLASS(xfdesktop_regular_file_icon_parent_class)->finalize(obj);
 }
@@ -272,133 +314,57 @@ cb_show_thumbnails_notify(GObject *gobject,
 }
 
 
-/* builds a folder/file path and then tests if that file is a valid image.
- * returns the file location if it does, NULL if it doesn't */
-static gchar *
-xfdesktop_check_file_is_valid(const gchar *folder, const gchar *file)
+static void
+xfdesktop_regular_file_icon_cover_ready(GObject *object,
+                                        const gchar *cover_path)
 {
-    gchar *path = g_strconcat(folder, "/", file, NULL);
+    XfdesktopRegularFileIcon *regular_icon = XFDESKTOP_REGULAR_FILE_ICON(object);
 
-    if(gdk_pixbuf_get_file_info(path, NULL, NULL) == NULL) {
-        g_free(path);
-        path = NULL;
-    }
+    regular_icon->priv->cover_scan_pending = FALSE;
 
-    return path;
+    /* found a cover, apply it */
+    if(cover_path && !regular_icon->priv->thumbnail_file) {
+        xfdesktop_regular_file_icon_set_thumbnail_file(XFDESKTOP_ICON(regular_icon),
+                                                       g_file_new_for_path(cover_path));
+    }
 }
 
-static gchar *
-xfdesktop_load_icon_location_from_folder(XfdesktopFileIcon *icon)
+static void
+xfdesktop_regular_file_icon_scan_cover(XfdesktopRegularFileIcon *regular_icon)
 {
-    gchar *icon_file = g_file_get_path(xfdesktop_file_icon_peek_file(icon));
-    gchar *path;
-
-    g_return_val_if_fail(icon_file, NULL);
-
-    /* So much for standards */
-    path = xfdesktop_check_file_is_valid(icon_file, "Folder.jpg");
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "folder.jpg");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "Folder.JPG");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "folder.JPG");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "folder.jpeg");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "folder.JPEG");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "Folder.JPEG");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "Folder.jpeg");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "Cover.jpg");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "cover.jpg");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "Cover.jpeg");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "cover.jpeg");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "albumart.jpg");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "albumart.jpeg");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "fanart.jpg");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "Fanart.jpg");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "fanart.JPG");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "Fanart.JPG");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "FANART.JPG");
-    }
-    if(path == NULL) {
-        path = xfdesktop_check_file_is_valid(icon_file, "FANART.jpg");
-    }
-
-    g_free(icon_file);
+    if(regular_icon->priv->cover_scan_pending)
+        return;
 
-    /* the file *should* already be a thumbnail */
-    return path;
+    regular_icon->priv->cover_scan_pending = TRUE;
+    xfdesktop_folder_cover_scan(regular_icon->priv->file,
+                                G_OBJECT(regular_icon),
+                                xfdesktop_regular_file_icon_cover_ready);
 }
 
 static GIcon *
 xfdesktop_load_icon_from_desktop_file(XfdesktopRegularFileIcon *regular_icon)
 {
-    gchar *contents;
-    gsize length;
+    const XfdesktopDesktopEntry *entry;
+    const gchar *icon_name;
     GIcon *gicon = NULL;
 
-    /* try to load the file into memory */
-    if(g_file_load_contents(regular_icon->priv->file, NULL, &contents, &length,
-                            NULL, NULL))
-    {
-        /* allocate a new key file */
-        GKeyFile *key_file = g_key_file_new();
-
-        /* try to parse the key file from the contents of the file */
-        if (g_key_file_load_from_data(key_file, contents, length, 0, NULL)) {
-            gchar *icon_name;
-            /* try to determine the custom icon name */
-            icon_name = g_key_file_get_string(key_file,
-                                              G_KEY_FILE_DESKTOP_GROUP,
-                                              G_KEY_FILE_DESKTOP_KEY_ICON,
-                                              NULL);
-
-            if(icon_name && g_file_test(icon_name, G_FILE_TEST_IS_REGULAR)) {
-                /* icon_name is an absolute path, create it as a file icon */
-                gicon = g_file_icon_new(g_file_new_for_path(icon_name));
-            } else if(icon_name) {
-                /* otherwise create a themed icon for it */
-                gicon = g_themed_icon_new(icon_name);
-            }
+    /* usually parsed already when the icon was added */
+    entry = xfdesktop_desktop_entry_lookup(regular_icon->priv->file,
+                                           regular_icon->priv->file_info);
+    if(!entry || !entry->icon)
+        return NULL;
 
-            if(icon_name)
-                g_free(icon_name);
-        }
+    /* the custom icon name */
+    icon_name = entry->icon;
 
-        /* free key file and in-memory data */
-        g_key_file_free(key_file);
-        g_free(contents);
+    if(g_file_test(icon_name, G_FILE_TEST_IS_REGULAR)) {
+        /* icon_name is an absolute path, create it as a file icon */
+        GFile *icon_file = g_file_new_for_path(icon_name);
+        gicon = g_file_icon_new(icon_file);
+        g_object_unref(icon_file);
+    } else {
+        /* otherwise create a themed icon for it */
+        gicon = g_themed_icon_new(icon_name);
     }
 
     return gicon;
@@ -418,33 +384,38 @@ xfdesktop_regular_file_icon_load_icon(XfdesktopIcon *icon)
         gicon = xfdesktop_load_icon_from_desktop_file(regular_icon);
 
     } else if(g_file_info_get_file_type(regular_icon->priv->file_info) == G_FILE_TYPE_DIRECTORY) {
-        /* Try to load a thumbnail from the standard folder image locations */
-        gchar *thumbnail_file = NULL;
-
-        if(regular_icon->priv->show_thumbnails)
-            thumbnail_file = xfdesktop_load_icon_location_from_folder(file_icon);
+        /* Try to load a thumbnail from the standard folder image locations;
+         * if we haven't seen the folder like this before, look for one in
+         * the background and show the plain folder icon until then */
+        if(regular_icon->priv->show_thumbnails && !regular_icon->priv->thumbnail_file) {
+            gchar *thumbnail_file = NULL;
+
+            if(xfdesktop_folder_cover_lookup(regular_icon->priv->file,
+                                             regular_icon->priv->file_info,
+                                             &thumbnail_file))
+            {
+                if(thumbnail_file)
+                    regular_icon->priv->thumbnail_file = g_file_new_for_path(thumbnail_file);
+                g_free(thumbnail_file);
+            } else
+                xfdesktop_regular_file_icon_scan_cover(regular_icon);
+        }
 
-        if(thumbnail_file) {
+        if(regular_icon->priv->show_thumbnails && regular_icon->priv->thumbnail_file) {
             /* If there's a folder thumbnail, use it */
-            regular_icon->priv->thumbnail_file = g_file_new_for_path(thumbnail_file);
             gicon = g_file_icon_new(regular_icon->priv->thumbnail_file);
-            g_free(thumbnail_file);
         }
 
     } else {
         /* If we have a thumbnail then they are enabled, use it. */
         if(regular_icon->priv->thumbnail_file) {
-            gchar *file = g_file_get_path(regular_icon->priv->file);
-            gchar *mimetype = xfdesktop_get_file_mimetype(file);
+            const gchar *content_type = g_file_info_get_content_type(regular_icon->priv->file_info);
 
             /* Don't use thumbnails for svg, use the file itself */
-            if(g_strcmp0(mimetype, "image/svg+xml") == 0)
+            if(g_strcmp0(content_type, "image/svg+xml") == 0)
                 gicon = g_file_icon_new(regular_icon->priv->file);
             else
                 gicon = g_file_icon_new(regular_icon->priv->thumbnail_file);
-
-            g_free(mimetype);
-            g_free(file);
         }
     }
 
@@ -489,25 +460,126 @@ xfdesktop_regular_file_icon_load_icon(XfdesktopIcon *icon)
     return gicon;
 }
 
+static void
+xfdesktop_regular_file_icon_icon_loaded(GdkPixbuf *pix,
+                                        gpointer user_data)
+{
+    XfdesktopRegularFileIcon *regular_icon = XFDESKTOP_REGULAR_FILE_ICON(user_data);
+
+    regular_icon->priv->icon_load = NULL;
+
+    /* on failure the placeholder stays */
+    if(regular_icon->priv->loaded_pix)
+        g_object_unref(regular_icon->priv->loaded_pix);
+    regular_icon->priv->loaded_pix = pix ? g_object_ref(pix) : NULL;
+
+    xfdesktop_icon_invalidate_pixbuf(XFDESKTOP_ICON(regular_icon));
+    xfdesktop_icon_pixbuf_changed(XFDESKTOP_ICON(regular_icon));
+}
+
+/* the icon was rebuilt, so whatever it loaded may be out of date; the old
+ * pixbuf is still shown until the new one is in */
+static void
+xfdesktop_regular_file_icon_forget_loaded_icon(XfdesktopRegularFileIcon *regular_icon)
+{
+    if(regular_icon->priv->icon_load) {
+        xfdesktop_icon_loader_cancel(regular_icon->priv->icon_load);
+        regular_icon->priv->icon_load = NULL;
+    }
+
+    if(regular_icon->priv->loaded_icon) {
+        g_object_unref(regular_icon->priv->loaded_icon);
+        regular_icon->priv->loaded_icon = NULL;
+    }
+}
+
+/* thumbnails, covers and image files named by launchers are decoded off the
+ * main thread.  until they're in, paint what we had before, or the plain
+ * icon for the file's type. */
+static GdkPixbuf *
+xfdesktop_regular_file_icon_get_loaded_pixbuf(XfdesktopRegularFileIcon *regular_icon,
+                                              GIcon *gicon,
+                                              GIcon *base_icon,
+                                              gint width, gint height)
+{
+    XfdesktopRegularFileIconPrivate *priv = regular_icon->priv;
+    GIcon *placeholder;
+
+    if(!priv->loaded_icon
+       || priv->loaded_width != width || priv->loaded_height != height
+       || !g_icon_equal(priv->loaded_icon, base_icon))
+    {
+        xfdesktop_regular_file_icon_forget_loaded_icon(regular_icon);
+
+        if(priv->loaded_pix
+           && (priv->loaded_width != width || priv->loaded_height != height))
+        {
+            g_object_unref(priv->loaded_pix);
+            priv->loaded_pix = NULL;
+        }
+
+        priv->loaded_icon = g_object_ref(base_icon);
+        priv->loaded_width = width;
+        priv->loaded_height = height;
+        priv->icon_load = xfdesktop_icon_loader_load(base_icon, width, height,
+                                                     priv->exposed,
+                                                     xfdesktop_regular_file_icon_icon_loaded,
+                                                     regular_icon);
+    }
+
+    if(priv->loaded_pix)
+        return xfdesktop_file_utils_decorate_icon(priv->loaded_pix, gicon,
+                                                  priv->pix_opacity);
+
+    placeholder = g_file_info_get_icon(priv->file_info);
+    if(G_IS_THEMED_ICON(placeholder))
+        return xfdesktop_file_utils_get_icon(placeholder, width, height,
+                                             priv->pix_opacity);
+
+    return xfdesktop_file_utils_get_fallback_icon(MIN(width, height));
+}
+
 static GdkPixbuf *
 xfdesktop_regular_file_icon_peek_pixbuf(XfdesktopIcon *icon,
                                         gint width, gint height)
 {
     XfdesktopRegularFileIcon *regular_icon = XFDESKTOP_REGULAR_FILE_ICON(icon);
-    GIcon *gicon = NULL;
+    GIcon *gicon = NULL, *base_icon;
     GdkPixbuf *pix = NULL;
 
-    if(!xfdesktop_file_icon_has_gicon(XFDESKTOP_FILE_ICON(icon)))
+    if(!xfdesktop_file_icon_has_gicon(XFDESKTOP_FILE_ICON(icon))) {
+        xfdesktop_regular_file_icon_forget_loaded_icon(regular_icon);
         gicon = xfdesktop_regular_file_icon_load_icon(icon);
-    else
+    } else
         g_object_get(XFDESKTOP_FILE_ICON(icon), "gicon", &gicon, NULL);
 
-    pix = xfdesktop_file_utils_get_icon(gicon, width, height,
-                                        regular_icon->priv->pix_opacity);
+    base_icon = G_IS_EMBLEMED_ICON(gicon)
+                ? g_emblemed_icon_get_icon(G_EMBLEMED_ICON(gicon))
+                : gicon;
+
+    if(G_IS_LOADABLE_ICON(base_icon)) {
+        pix = xfdesktop_regular_file_icon_get_loaded_pixbuf(regular_icon, gicon,
+                                                            base_icon,
+                                                            width, height);
+    } else {
+        pix = xfdesktop_file_utils_get_icon(gicon, width, height,
+                                            regular_icon->priv->pix_opacity);
+    }
 
     return pix;
 }
 
+static void
+xfdesktop_regular_file_icon_exposed(XfdesktopIcon *icon)
+{
+    XfdesktopRegularFileIcon *regular_icon = XFDESKTOP_REGULAR_FILE_ICON(icon);
+
+    regular_icon->priv->exposed = TRUE;
+
+    if(regular_icon->priv->icon_load)
+        xfdesktop_icon_loader_set_visible(regular_icon->priv->icon_load);
+}
+
 static GdkPixbuf *
 xfdesktop_regular_file_icon_peek_tooltip_pixbuf(XfdesktopIcon *icon,
                                                 gint width, gint height)
@@ -744,14 +816,13 @@ xfdesktop_regular_file_icon_peek_tooltip(XfdesktopIcon *icon)
         /* Extract the Comment entry from the .desktop file */
         if(is_desktop_file)
         {
-            gchar *path = g_file_get_path(regular_file_icon->priv->file);
-            XfceRc *rcfile = xfce_rc_simple_open(path, TRUE);
-            g_free(path);
+            const XfdesktopDesktopEntry *entry;
+
+            entry = xfdesktop_desktop_entry_lookup(regular_file_icon->priv->file,
+                                                   info);
+            if(entry)
+                comment = entry->comment;
 
-            if(rcfile) {
-                xfce_rc_set_group(rcfile, "Desktop Entry");
-                comment = xfce_rc_read_entry(rcfile, "Comment", NULL);
-            }
             /* Prepend the comment to the tooltip */
             if(comment != NULL) {
                 gchar *tooltip = regular_file_icon->priv->tooltip;
@@ -760,8 +831,6 @@ xfdesktop_regular_file_icon_peek_tooltip(XfdesktopIcon *icon)
                                                                    tooltip);
                 g_free(tooltip);
             }
-
-            xfce_rc_close(rcfile);
         }
 
         g_free(time_string);
@@ -825,6 +894,38 @@ xfdesktop_regular_file_icon_peek_file(XfdesktopFileIcon *icon)
     return XFDESKTOP_REGULAR_FILE_ICON(icon)->priv->file;
 }
 
+static void
+xfdesktop_regular_file_icon_set_filesystem_info(GObject *object,
+                                                GFileInfo *filesystem_info)
+{
+    XfdesktopRegularFileIcon *regular_file_icon = XFDESKTOP_REGULAR_FILE_ICON(object);
+
+    if(regular_file_icon->priv->filesystem_info)
+        g_object_unref(regular_file_icon->priv->filesystem_info);
+
+    regular_file_icon->priv->filesystem_info = filesystem_info
+                                               ? g_object_ref(filesystem_info)
+                                               : NULL;
+}
+
+static void
+xfdesktop_regular_file_icon_file_info_ready(GObject *source,
+                                            GAsyncResult *result,
+                                            gpointer user_data)
+{
+    XfdesktopFileIcon *icon = XFDESKTOP_FILE_ICON(user_data);
+    GFileInfo *info;
+
+    info = g_file_query_info_finish(G_FILE(source), result, NULL);
+    if(info) {
+        /* emits label-changed and pixbuf-changed as needed */
+        xfdesktop_file_icon_update_file_info(icon, info);
+        g_object_unref(info);
+    }
+
+    g_object_unref(icon);
+}
+
 static void
 xfdesktop_regular_file_icon_update_file_info(XfdesktopFileIcon *icon,
                                              GFileInfo *info)
@@ -844,12 +945,11 @@ xfdesktop_regular_file_icon_update_file_info(XfdesktopFileIcon *icon,
 
     regular_file_icon->priv->file_info = g_object_ref(info);
 
-    if(regular_file_icon->priv->filesystem_info)
-        g_object_unref(regular_file_icon->priv->filesystem_info);
-
-    regular_file_icon->priv->filesystem_info = g_file_query_filesystem_info(regular_file_icon->priv->file,
-                                                                            XFDESKTOP_FILESYSTEM_INFO_NAMESPACE,
-                                                                            NULL, NULL);
+    /* usually answered from the cache without touching the disk */
+    xfdesktop_file_utils_get_filesystem_info(regular_file_icon->priv->file,
+                                             info,
+                                             G_OBJECT(icon),
+                                             xfdesktop_regular_file_icon_set_filesystem_info);
 
     /* get both, old and new display name */
     old_display_name = regular_file_icon->priv->display_name;
@@ -879,15 +979,14 @@ xfdesktop_regular_file_icon_update_file_info(XfdesktopFileIcon *icon,
     xfdesktop_icon_pixbuf_changed(XFDESKTOP_ICON(icon));
 }
 
+/* the manager's folder watcher only passes on changes to cover candidates */
 static void
-cb_folder_contents_changed(GFileMonitor     *monitor,
-                           GFile            *file,
-                           GFile            *other_file,
+cb_folder_contents_changed(GFile            *folder,
+                           GFile            *child,
                            GFileMonitorEvent event,
                            gpointer          user_data)
 {
     XfdesktopRegularFileIcon *regular_file_icon;
-    gchar *thumbnail_file = NULL;
 
     if(!user_data || !XFDESKTOP_IS_REGULAR_FILE_ICON(user_data))
         return;
@@ -898,20 +997,34 @@ cb_folder_contents_changed(GFileMonitor     *monitor,
     if(!regular_file_icon->priv->show_thumbnails)
         return;
 
-    /* Already has a thumbnail */
-    if(regular_file_icon->priv->thumbnail_file != NULL)
-        return;
-
     switch(event) {
+        case G_FILE_MONITOR_EVENT_DELETED:
+            /* lost our cover, look for another one */
+            if(regular_file_icon->priv->thumbnail_file
+               && g_file_equal(child, regular_file_icon->priv->thumbnail_file))
+            {
+                xfdesktop_regular_file_icon_set_thumbnail_file(XFDESKTOP_ICON(regular_file_icon),
+                                                               NULL);
+                xfdesktop_regular_file_icon_scan_cover(regular_file_icon);
+            }
+            break;
+        case G_FILE_MONITOR_EVENT_CHANGED:
+            /* polling noticed the folder changed, but not what changed, or
+             * our cover itself changed: it may be gone or replaced, so
+             * don't trust it */
+            if(regular_file_icon->priv->thumbnail_file
+               && (!child || g_file_equal(child, regular_file_icon->priv->thumbnail_file)))
+            {
+                xfdesktop_regular_file_icon_set_thumbnail_file(XFDESKTOP_ICON(regular_file_icon),
+                                                               NULL);
+                xfdesktop_regular_file_icon_scan_cover(regular_file_icon);
+                break;
+            }
+            /* fall through */
         case G_FILE_MONITOR_EVENT_CREATED:
-                thumbnail_file = xfdesktop_load_icon_location_from_folder(XFDESKTOP_FILE_ICON(regular_file_icon));
-                if(thumbnail_file) {
-                    GFile *thumbnail = g_file_new_for_path(thumbnail_file);
-                    /* found a thumbnail file, apply it */
-                    xfdesktop_regular_file_icon_set_thumbnail_file(XFDESKTOP_ICON(regular_file_icon),
-                                                                   thumbnail);
-                    g_free(thumbnail_file);
-                }
+            /* a new cover */
+            if(regular_file_icon->priv->thumbnail_file == NULL)
+                xfdesktop_regular_file_icon_scan_cover(regular_file_icon);
             break;
         default:
             break;
@@ -941,16 +1054,22 @@ xfdesktop_regular_file_icon_new(GFile *file,
     regular_file_icon->priv->display_name = xfdesktop_file_utils_get_display_name(file, 
                                                                                   file_info);
 
-    /* query file system information from GIO */
-    regular_file_icon->priv->filesystem_info = g_file_query_filesystem_info(regular_file_icon->priv->file,
-                                                                            XFDESKTOP_FILESYSTEM_INFO_NAMESPACE,
-                                                                            NULL, NULL);
+    /* the file info we were given is the one we use; filesystem info is
+     * shared between all icons on the same filesystem */
+    xfdesktop_file_utils_get_filesystem_info(file, file_info,
+                                             G_OBJECT(regular_file_icon),
+                                             xfdesktop_regular_file_icon_set_filesystem_info);
 
-    /* query file information from GIO */
-    regular_file_icon->priv->file_info = g_file_query_info(regular_file_icon->priv->file,
-                                                           XFDESKTOP_FILE_INFO_NAMESPACE,
-                                                           G_FILE_QUERY_INFO_NONE,
-                                                           NULL, NULL);
+    /* some backends leave out attributes when enumerating; fetch them and
+     * update the label and icon once they're in */
+    if(!g_file_info_has_attribute(file_info, G_FILE_ATTRIBUTE_STANDARD_ICON)
+       || !g_file_info_has_attribute(file_info, G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME))
+    {
+        g_file_query_info_async(file, XFDESKTOP_FILE_INFO_NAMESPACE,
+                                G_FILE_QUERY_INFO_NONE, G_PRIORITY_DEFAULT, NULL,
+                                xfdesktop_regular_file_icon_file_info_ready,
+                                g_object_ref(regular_file_icon));
+    }
 
     regular_file_icon->priv->gscreen = screen;
 
@@ -962,14 +1081,15 @@ xfdesktop_regular_file_icon_new(GFile *file,
                              regular_file_icon);
 
     if(g_file_info_get_file_type(regular_file_icon->priv->file_info) == G_FILE_TYPE_DIRECTORY) {
-        regular_file_icon->priv->monitor = g_file_monitor(regular_file_icon->priv->file,
-                                                          G_FILE_MONITOR_NONE,
-                                                          NULL,
-                                                          NULL);
-
-        g_signal_connect(regular_file_icon->priv->monitor, "changed",
-                         G_CALLBACK(cb_folder_contents_changed),
-                         regular_file_icon);
+        /* the icon may outlive the manager on shutdown */
+        g_object_add_weak_pointer(G_OBJECT(fmanager),
+                                  (gpointer *)&regular_file_icon->priv->fmanager);
+
+        xfdesktop_file_icon_manager_watch_folder(fmanager,
+                                                 regular_file_icon->priv->file,
+                                                 cb_folder_contents_changed,
+                                                 regular_file_icon);
+        regular_file_icon->priv->watching_folder = TRUE;
 
         g_object_get(regular_file_icon->priv->fmanager,
                      "show-thumbnails", &regular_file_icon->priv->show_thumbnails,
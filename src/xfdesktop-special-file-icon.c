@@ -52,6 +52,11 @@
 #include "xfdesktop-file-utils.h"
 #include "xfdesktop-special-file-icon.h"
 
+/* how long the trash has to be quiet before it's recounted (in ms), and
+ * how many items are counted per step when gvfs can't tell us */
+#define TRASH_COUNT_DELAY  500
+#define TRASH_COUNT_BATCH  256
+
 struct _XfdesktopSpecialFileIconPrivate
 {
     XfdesktopSpecialFileIconType type;
@@ -64,8 +69,18 @@ struct _XfdesktopSpecialFileIconPrivate
     
     /* only needed for trash */
     guint trash_item_count;
+    guint trash_recount_id;
+    GCancellable *trash_cancellable;
 };
 
+typedef struct
+{
+    XfdesktopSpecialFileIcon *icon;
+    GCancellable *cancellable;
+    GFileEnumerator *enumerator;
+    guint n_items;
+} XfdesktopTrashCount;
+
 static void xfdesktop_special_file_icon_finalize(GObject *obj);
 
 static GdkPixbuf *xfdesktop_special_file_icon_peek_pixbuf(XfdesktopIcon *icon,
@@ -92,6 +107,8 @@ static void xfdesktop_special_file_icon_changed(GFileMonitor *monitor,
                                                 GFile *other_file,
                                                 GFileMonitorEvent event,
                                                 XfdesktopSpecialFileIcon *special_file_icon);
+static void xfdesktop_special_file_icon_set_trash_count(XfdesktopSpecialFileIcon *special_file_icon,
+                                                        guint n_items);
 static void xfdesktop_special_file_icon_update_trash_count(XfdesktopSpecialFileIcon *special_file_icon);
 
 #ifdef HAVE_THUNARX
@@ -161,6 +178,15 @@ xfdesktop_special_file_icon_finalize(GObject *obj)
                                              icon);
         g_object_unref(icon->priv->monitor);
     }
+
+    if(icon->priv->trash_recount_id)
+        g_source_remove(icon->priv->trash_recount_id);
+
+    /* a running count sees this and leaves us alone */
+    if(icon->priv->trash_cancellable) {
+        g_cancellable_cancel(icon->priv->trash_cancellable);
+        g_object_unref(icon->priv->trash_cancellable);
+    }
     
     g_object_unref(icon->priv->file);
 
@@ -597,6 +623,40 @@ xfdesktop_special_file_icon_peek_file(XfdesktopFileIcon *icon)
     return XFDESKTOP_SPECIAL_FILE_ICON(icon)->priv->file;
 }
 
+static gboolean
+xfdesktop_special_file_icon_trash_recount(gpointer user_data)
+{
+    XfdesktopSpecialFileIcon *special_file_icon = user_data;
+
+    special_file_icon->priv->trash_recount_id = 0;
+    xfdesktop_special_file_icon_update_trash_count(special_file_icon);
+
+    return FALSE;
+}
+
+static void
+xfdesktop_special_file_icon_trash_changed(XfdesktopSpecialFileIcon *special_file_icon,
+                                          GFile *file,
+                                          GFileMonitorEvent event)
+{
+    guint n_items = special_file_icon->priv->trash_item_count;
+
+    /* keep the count roughly right while things are moving... */
+    if(!g_file_equal(file, special_file_icon->priv->file)) {
+        if(event == G_FILE_MONITOR_EVENT_CREATED)
+            xfdesktop_special_file_icon_set_trash_count(special_file_icon, n_items + 1);
+        else if(event == G_FILE_MONITOR_EVENT_DELETED && n_items > 0)
+            xfdesktop_special_file_icon_set_trash_count(special_file_icon, n_items - 1);
+    }
+
+    /* ...and get the real one once they've settled down */
+    if(special_file_icon->priv->trash_recount_id)
+        g_source_remove(special_file_icon->priv->trash_recount_id);
+    special_file_icon->priv->trash_recount_id = g_timeout_add(TRASH_COUNT_DELAY,
+                                                              xfdesktop_special_file_icon_trash_recount,
+                                                              special_file_icon);
+}
+
 static void
 xfdesktop_special_file_icon_changed(GFileMonitor *monitor,
                                     GFile *file,
@@ -614,6 +674,13 @@ xfdesktop_special_file_icon_changed(GFileMonitor *monitor,
        event == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT)
         return;
 
+    /* emptying a big trash sends an event per item; don't requery
+     * anything for each of them */
+    if(special_file_icon->priv->type == XFDESKTOP_SPECIAL_FILE_ICON_TRASH) {
+        xfdesktop_special_file_icon_trash_changed(special_file_icon, file, event);
+        return;
+    }
+
     /* release the old file information */
     if(special_file_icon->priv->file_info) {
         g_object_unref(special_file_icon->priv->file_info);
@@ -637,10 +704,6 @@ xfdesktop_special_file_icon_changed(GFileMonitor *monitor,
                                                                             XFDESKTOP_FILESYSTEM_INFO_NAMESPACE,
                                                                             NULL, NULL);
 
-    /* update the trash full state */
-    if(special_file_icon->priv->type == XFDESKTOP_SPECIAL_FILE_ICON_TRASH)
-        xfdesktop_special_file_icon_update_trash_count(special_file_icon);
-
     /* invalidate the tooltip */
     g_free(special_file_icon->priv->tooltip);
     special_file_icon->priv->tooltip = NULL;
@@ -652,45 +715,164 @@ xfdesktop_special_file_icon_changed(GFileMonitor *monitor,
 }
 
 static void
-xfdesktop_special_file_icon_update_trash_count(XfdesktopSpecialFileIcon *special_file_icon)
+xfdesktop_special_file_icon_set_trash_count(XfdesktopSpecialFileIcon *special_file_icon,
+                                            guint n_items)
 {
-    GFileEnumerator *enumerator;
-    GFileInfo *f_info;
-    gint n = 0;
+    gboolean was_empty = special_file_icon->priv->trash_item_count == 0;
 
-    g_return_if_fail(XFDESKTOP_IS_SPECIAL_FILE_ICON(special_file_icon));
+    special_file_icon->priv->trash_item_count = n_items;
+
+    /* the tooltip shows the count */
+    g_free(special_file_icon->priv->tooltip);
+    special_file_icon->priv->tooltip = NULL;
 
-    if(special_file_icon->priv->file_info == NULL
-       || special_file_icon->priv->type != XFDESKTOP_SPECIAL_FILE_ICON_TRASH)
-    {
+    /* the icon only shows whether it's empty */
+    if(was_empty != (n_items == 0)) {
+        xfdesktop_file_icon_invalidate_icon(XFDESKTOP_FILE_ICON(special_file_icon));
+        xfdesktop_icon_invalidate_pixbuf(XFDESKTOP_ICON(special_file_icon));
+        xfdesktop_icon_pixbuf_changed(XFDESKTOP_ICON(special_file_icon));
+    }
+}
+
+static void
+xfdesktop_trash_count_free(XfdesktopTrashCount *count)
+{
+    if(count->enumerator) {
+        g_file_enumerator_close_async(count->enumerator, G_PRIORITY_LOW,
+                                      NULL, NULL, NULL);
+        g_object_unref(count->enumerator);
+    }
+    g_object_unref(count->cancellable);
+    g_slice_free(XfdesktopTrashCount, count);
+}
+
+static void
+xfdesktop_trash_count_files_ready(GObject *source,
+                                  GAsyncResult *result,
+                                  gpointer user_data)
+{
+    XfdesktopTrashCount *count = user_data;
+    GList *files;
+
+    files = g_file_enumerator_next_files_finish(count->enumerator, result, NULL);
+
+    if(g_cancellable_is_cancelled(count->cancellable)) {
+        g_list_foreach(files, (GFunc)g_object_unref, NULL);
+        g_list_free(files);
+        xfdesktop_trash_count_free(count);
+        return;
+    }
+
+    if(files) {
+        count->n_items += g_list_length(files);
+        g_list_foreach(files, (GFunc)g_object_unref, NULL);
+        g_list_free(files);
+
+        g_file_enumerator_next_files_async(count->enumerator, TRASH_COUNT_BATCH,
+                                           G_PRIORITY_LOW, count->cancellable,
+                                           xfdesktop_trash_count_files_ready,
+                                           count);
+        return;
+    }
+
+    TRACE("exiting, trash count %d", count->n_items);
+    xfdesktop_special_file_icon_set_trash_count(count->icon, count->n_items);
+    xfdesktop_trash_count_free(count);
+}
+
+static void
+xfdesktop_trash_count_enumerate_ready(GObject *source,
+                                      GAsyncResult *result,
+                                      gpointer user_data)
+{
+    XfdesktopTrashCount *count = user_data;
+
+    count->enumerator = g_file_enumerate_children_finish(G_FILE(source), result, NULL);
+
+    if(!count->enumerator || g_cancellable_is_cancelled(count->cancellable)) {
+        xfdesktop_trash_count_free(count);
         return;
     }
 
+    g_file_enumerator_next_files_async(count->enumerator, TRASH_COUNT_BATCH,
+                                       G_PRIORITY_LOW, count->cancellable,
+                                       xfdesktop_trash_count_files_ready,
+                                       count);
+}
+
+static void
+xfdesktop_trash_count_info_ready(GObject *source,
+                                 GAsyncResult *result,
+                                 gpointer user_data)
+{
+    XfdesktopTrashCount *count = user_data;
+    XfdesktopSpecialFileIcon *special_file_icon = count->icon;
+    GFileInfo *info;
+
+    info = g_file_query_info_finish(G_FILE(source), result, NULL);
+
+    if(g_cancellable_is_cancelled(count->cancellable)) {
+        if(info)
+            g_object_unref(info);
+        xfdesktop_trash_count_free(count);
+        return;
+    }
+
+    if(info) {
+        if(special_file_icon->priv->file_info)
+            g_object_unref(special_file_icon->priv->file_info);
+        special_file_icon->priv->file_info = info;
+
+        /* gvfs keeps count for us */
+        if(g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_TRASH_ITEM_COUNT)) {
+            xfdesktop_special_file_icon_set_trash_count(special_file_icon,
+                                                        g_file_info_get_attribute_uint32(info,
+                                                                                         G_FILE_ATTRIBUTE_TRASH_ITEM_COUNT));
+            xfdesktop_trash_count_free(count);
+            return;
+        }
+    }
+
     /* The trash count may return a number of files the user can't
      * currently delete, for example if the file is in a removable
      * drive that isn't mounted.
      */
-    enumerator = g_file_enumerate_children(special_file_icon->priv->file,
-                                           G_FILE_ATTRIBUTE_ACCESS_CAN_DELETE,
-                                           G_FILE_QUERY_INFO_NONE,
-                                           NULL,
-                                           NULL);
-    if(enumerator == NULL)
-        return;
+    g_file_enumerate_children_async(special_file_icon->priv->file,
+                                    G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                    G_FILE_QUERY_INFO_NONE,
+                                    G_PRIORITY_LOW, count->cancellable,
+                                    xfdesktop_trash_count_enumerate_ready,
+                                    count);
+}
 
-    for(f_info = g_file_enumerator_next_file(enumerator, NULL, NULL);
-        f_info != NULL;
-        f_info = g_file_enumerator_next_file(enumerator, NULL, NULL))
-    {
-          n++;
-          g_object_unref(f_info);
-    }
+/* refreshes the trash's file info and item count in the background,
+ * dropping a count that's still running */
+static void
+xfdesktop_special_file_icon_update_trash_count(XfdesktopSpecialFileIcon *special_file_icon)
+{
+    XfdesktopTrashCount *count;
 
-    g_file_enumerator_close(enumerator, NULL, NULL);
-    g_object_unref(enumerator);
+    g_return_if_fail(XFDESKTOP_IS_SPECIAL_FILE_ICON(special_file_icon));
 
-    special_file_icon->priv->trash_item_count = n;
-    TRACE("exiting, trash count %d", n);
+    if(special_file_icon->priv->type != XFDESKTOP_SPECIAL_FILE_ICON_TRASH)
+        return;
+
+    if(special_file_icon->priv->trash_cancellable) {
+        g_cancellable_cancel(special_file_icon->priv->trash_cancellable);
+        g_object_unref(special_file_icon->priv->trash_cancellable);
+    }
+    special_file_icon->priv->trash_cancellable = g_cancellable_new();
+
+    count = g_slice_new0(XfdesktopTrashCount);
+    count->icon = special_file_icon;
+    count->cancellable = g_object_ref(special_file_icon->priv->trash_cancellable);
+
+    g_file_query_info_async(special_file_icon->priv->file,
+                            XFDESKTOP_FILE_INFO_NAMESPACE,
+                            G_FILE_QUERY_INFO_NONE,
+                            G_PRIORITY_DEFAULT, count->cancellable,
+                            xfdesktop_trash_count_info_ready,
+                            count);
 }
 
 /* public API */
@@ -738,9 +920,17 @@ xfdesktop_special_file_icon_new(XfdesktopSpecialFileIconType type,
     special_file_icon->priv->filesystem_info = g_file_query_filesystem_info(special_file_icon->priv->file,
                                                                             XFDESKTOP_FILESYSTEM_INFO_NAMESPACE,
                                                                             NULL, NULL);
-    /* update the trash full state */
-    if(type == XFDESKTOP_SPECIAL_FILE_ICON_TRASH)
-        xfdesktop_special_file_icon_update_trash_count(special_file_icon);
+    /* update the trash full state; use gvfs' count if it has one */
+    if(type == XFDESKTOP_SPECIAL_FILE_ICON_TRASH) {
+        if(g_file_info_has_attribute(special_file_icon->priv->file_info,
+                                     G_FILE_ATTRIBUTE_TRASH_ITEM_COUNT))
+        {
+            special_file_icon->priv->trash_item_count =
+                g_file_info_get_attribute_uint32(special_file_icon->priv->file_info,
+                                                 G_FILE_ATTRIBUTE_TRASH_ITEM_COUNT);
+        } else
+            xfdesktop_special_file_icon_update_trash_count(special_file_icon);
+    }
 
     g_signal_connect_swapped(G_OBJECT(gtk_icon_theme_get_for_screen(screen)),
                              "changed",